@@ -0,0 +1,13 @@
+# Function to add a benchmark executable.
+# bench_name:   Benchmark executable name.
+# bench_source: Benchmark source file name.
+# bench_libs:   Benchmark link libraries as ';' separated list.
+find_package(Threads REQUIRED)
+
+function(benchmark bench_name bench_source bench_libs)
+    add_executable(${bench_name} ${bench_source})
+    target_link_libraries(${bench_name}
+        PRIVATE
+            ${bench_libs}
+            Threads::Threads)
+endfunction()
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string_view>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace SpeechTools::Bench {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Runs a callable once and returns its wall-clock duration in seconds.
+ * @param fn The callable to time.
+ * @return The elapsed time in seconds.
+ */
+template <typename Fn>
+double timeIt(Fn&& fn) {
+  auto start = Clock::now();
+  fn();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Prints one result row as "<name> <label>: <rate> <unit>/s".
+ * @param name The benchmark name.
+ * @param label The variant being measured (e.g. batch size).
+ * @param ops The number of operations performed.
+ * @param seconds The time taken to perform them.
+ * @param unit The operation unit to print.
+ */
+inline void report(std::string_view name, std::string_view label, double ops,
+                   double seconds, std::string_view unit = "elems") {
+  std::printf("%-24.*s %-16.*s %12.2f M%.*s/s\n",
+              static_cast<int>(name.size()), name.data(),
+              static_cast<int>(label.size()), label.data(),
+              ops / seconds / 1e6, static_cast<int>(unit.size()), unit.data());
+}
+
+/**
+ * @brief Prints one result row as "<name> <label>: <value> <unit>", for
+ * measurements that are not rates.
+ * @param name The benchmark name.
+ * @param label The variant being measured.
+ * @param value The measured value.
+ * @param unit The unit to print after the value.
+ */
+inline void reportValue(std::string_view name, std::string_view label,
+                        double value, std::string_view unit) {
+  std::printf("%-24.*s %-16.*s %12.2f %.*s\n",
+              static_cast<int>(name.size()), name.data(),
+              static_cast<int>(label.size()), label.data(), value,
+              static_cast<int>(unit.size()), unit.data());
+}
+
+/**
+ * @brief Returns the CPU time used so far by all threads of the process.
+ * @return The process CPU time in seconds.
+ */
+inline double cpuSeconds() {
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief Pins the calling thread to a CPU core where the platform supports it.
+ * @param core The zero-based core index.
+ * @return true if the thread was pinned, false otherwise.
+ */
+inline bool pinToCore(int core) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)core;
+  return false;
+#endif
+}
+
+}  // namespace SpeechTools::Bench
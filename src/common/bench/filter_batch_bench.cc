@@ -0,0 +1,70 @@
+// Measures SpeechFilter throughput for a trivial filter as the batch size
+// grows, i.e. how much of the per-frame cost is queue and dispatch overhead.
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+#include "bench_util.hh"
+
+using namespace SpeechTools::Bench;
+
+namespace {
+
+constexpr size_t kElements = 4'000'000;
+constexpr size_t kChunk = 64;
+
+using IntQueue = SPSCLockFreeQueue<int>;
+
+// Adds one to every element.
+class IncrementFilter
+    : public SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue> {
+ public:
+  IncrementFilter(IntQueue& in, IntQueue& out, size_t max_batch)
+      : SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue>(
+            in, out, SpeechTools::WaitStrategy::kYield, max_batch) {}
+
+ protected:
+  int process(const int& input_data) override { return input_data + 1; }
+};
+
+double run(size_t max_batch) {
+  IntQueue in(1024), out(1024);
+  IncrementFilter filter(in, out, max_batch);
+  std::vector<int> chunk(kChunk, 0);
+
+  return timeIt([&] {
+    std::thread producer([&] {
+      for (size_t sent = 0; sent < kElements;) {
+        size_t n =
+            in.try_push_n(chunk.begin(), std::min(kChunk, kElements - sent));
+        if (n == 0) {
+          std::this_thread::yield();
+        }
+        sent += n;
+      }
+    });
+    std::vector<int> received(kChunk);
+    for (size_t got = 0; got < kElements;) {
+      size_t n = out.try_pop_n(received.begin(), kChunk);
+      if (n == 0) {
+        std::this_thread::yield();
+      }
+      got += n;
+    }
+    producer.join();
+  });
+}
+
+}  // namespace
+
+int main() {
+  for (size_t batch : {1, 4, 16, 64}) {
+    std::string label = "batch=" + std::to_string(batch);
+    report("filter_batch", label, kElements, run(batch));
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+// Compares SpeechFilter wait strategies: the CPU a filter thread burns while
+// its input queue is empty, and the latency from a push into an idle filter
+// to its output. The main thread sleeps while measuring CPU, so the process
+// CPU time is the filter thread's. Parking runs over SPSCParkingQueue, the
+// others over the default non-parking queue.
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+#include "bench_util.hh"
+
+using namespace SpeechTools::Bench;
+using SpeechTools::WaitStrategy;
+
+namespace {
+
+constexpr auto kIdlePeriod = std::chrono::milliseconds(500);
+constexpr int kSamples = 200;
+// Long enough for every strategy to reach its idle wait between samples.
+constexpr auto kSampleGap = std::chrono::milliseconds(2);
+
+// Passes timestamps through unchanged.
+template <template <typename> class Queue>
+class ForwardFilter
+    : public SpeechTools::SpeechFilter<int64_t, int64_t, Queue> {
+ public:
+  ForwardFilter(Queue<int64_t>& in, Queue<int64_t>& out, WaitStrategy wait)
+      : SpeechTools::SpeechFilter<int64_t, int64_t, Queue>(in, out, wait) {}
+
+ protected:
+  int64_t process(const int64_t& input_data) override { return input_data; }
+};
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+template <template <typename> class Queue>
+void run(const char* label, WaitStrategy wait) {
+  Queue<int64_t> in(64), out(64);
+  ForwardFilter<Queue> filter(in, out, wait);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  double cpu_start = cpuSeconds();
+  double idle_seconds =
+      timeIt([] { std::this_thread::sleep_for(kIdlePeriod); });
+  double cpu_percent = (cpuSeconds() - cpu_start) / idle_seconds * 100.0;
+  reportValue("filter_idle_cpu", label, cpu_percent, "% of a core");
+
+  std::vector<double> latencies_us;
+  latencies_us.reserve(kSamples);
+  for (int i = 0; i < kSamples; ++i) {
+    std::this_thread::sleep_for(kSampleGap);
+    in.push(nowNs());
+    int64_t sent;
+    out.pop(sent);
+    latencies_us.push_back(static_cast<double>(nowNs() - sent) / 1e3);
+  }
+  std::sort(latencies_us.begin(), latencies_us.end());
+  reportValue("filter_wake_p50", label, latencies_us[kSamples / 2], "us");
+  reportValue("filter_wake_p99", label, latencies_us[kSamples * 99 / 100],
+              "us");
+}
+
+}  // namespace
+
+int main() {
+  run<SPSCLockFreeQueue>("busy_spin", WaitStrategy::kBusySpin);
+  run<SPSCLockFreeQueue>("yield", WaitStrategy::kYield);
+  run<SPSCParkingQueue>("park", WaitStrategy::kPark);
+  return 0;
+}
@@ -0,0 +1,114 @@
+// Throughput of MPMCLockFreeQueue against a mutex and condition variable queue
+// at 2, 4, 8 and 16 threads, half producers and half consumers, as when
+// several filter workers share one input queue.
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/mpmc_queue.hh"
+#include "bench_util.hh"
+
+using namespace SpeechTools::Bench;
+
+namespace {
+
+constexpr size_t kElements = 4'000'000;
+constexpr size_t kCapacity = 1024;
+
+// Bounded blocking queue guarded by a mutex, with condition variables for the
+// full and empty cases.
+template <typename T>
+class CondVarQueue {
+ public:
+  explicit CondVarQueue(size_t capacity) : capacity_(capacity) {}
+
+  void push(const T& value) {
+    {
+      std::unique_lock lock(mutex_);
+      not_full_.wait(lock, [&] { return items_.size() < capacity_; });
+      items_.push_back(value);
+    }
+    not_empty_.notify_one();
+  }
+
+  void pop(T& value) {
+    {
+      std::unique_lock lock(mutex_);
+      not_empty_.wait(lock, [&] { return !items_.empty(); });
+      value = items_.front();
+      items_.pop_front();
+    }
+    not_full_.notify_one();
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> items_;
+};
+
+// Adapts the lock-free queue to the blocking interface by yielding.
+template <typename T>
+class LockFreeQueue {
+ public:
+  explicit LockFreeQueue(size_t capacity) : queue_(capacity) {}
+
+  void push(const T& value) {
+    while (!queue_.try_push(value)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void pop(T& value) {
+    while (!queue_.try_pop(value)) {
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  MPMCLockFreeQueue<T> queue_;
+};
+
+template <template <typename> class Queue>
+double run(size_t threads) {
+  Queue<size_t> q(kCapacity);
+  const size_t pairs = threads / 2;
+  const size_t per_thread = kElements / pairs;
+  return timeIt([&] {
+    std::vector<std::thread> workers;
+    for (size_t p = 0; p < pairs; ++p) {
+      workers.emplace_back([&] {
+        for (size_t i = 0; i < per_thread; ++i) {
+          q.push(i);
+        }
+      });
+      workers.emplace_back([&] {
+        size_t v;
+        for (size_t i = 0; i < per_thread; ++i) {
+          q.pop(v);
+        }
+      });
+    }
+    for (auto& t : workers) {
+      t.join();
+    }
+  });
+}
+
+}  // namespace
+
+int main() {
+  for (size_t threads = 2; threads <= 16; threads *= 2) {
+    std::string label = "threads=" + std::to_string(threads);
+    size_t ops = kElements / (threads / 2) * (threads / 2);
+    report("mpmc_lockfree", label, ops, run<LockFreeQueue>(threads), "ops");
+    report("mpmc_condvar", label, ops, run<CondVarQueue>(threads), "ops");
+  }
+  return 0;
+}
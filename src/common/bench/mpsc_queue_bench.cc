@@ -0,0 +1,88 @@
+// Contention benchmark for MPSCLockFreeQueue with 1-16 producers feeding one
+// consumer, against a std::mutex-protected std::deque as a reference.
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/mpsc_queue.hh"
+#include "bench_util.hh"
+
+using namespace SpeechTools::Bench;
+
+namespace {
+
+constexpr size_t kElements = 4'000'000;
+constexpr size_t kCapacity = 1024;
+
+// Bounded queue guarded by a single mutex.
+template <typename T>
+class MutexQueue {
+ public:
+  explicit MutexQueue(size_t capacity) : capacity_(capacity) {}
+
+  bool try_push(const T& value) {
+    std::lock_guard lock(mutex_);
+    if (items_.size() == capacity_) {
+      return false;
+    }
+    items_.push_back(value);
+    return true;
+  }
+
+  bool try_pop(T& value) {
+    std::lock_guard lock(mutex_);
+    if (items_.empty()) {
+      return false;
+    }
+    value = items_.front();
+    items_.pop_front();
+    return true;
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::deque<T> items_;
+};
+
+template <template <typename> class Queue>
+double run(size_t producers) {
+  Queue<size_t> q(kCapacity);
+  const size_t per_producer = kElements / producers;
+  return timeIt([&] {
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+      threads.emplace_back([&] {
+        for (size_t i = 0; i < per_producer; ++i) {
+          while (!q.try_push(i)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    size_t v;
+    for (size_t i = 0; i < per_producer * producers; ++i) {
+      while (!q.try_pop(v)) {
+      }
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  });
+}
+
+}  // namespace
+
+int main() {
+  for (size_t producers = 1; producers <= 16; producers *= 2) {
+    std::string label = "producers=" + std::to_string(producers);
+    size_t ops = kElements / producers * producers;
+    report("mpsc_lockfree", label, ops, run<MPSCLockFreeQueue>(producers),
+           "ops");
+    report("mpsc_mutex", label, ops, run<MutexQueue>(producers), "ops");
+  }
+  return 0;
+}
@@ -0,0 +1,75 @@
+// Throughput of the single-element try_push/try_pop path versus the batch
+// try_push_n/try_pop_n path for batch sizes 1-64, with the producer and the
+// consumer on separate threads.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/spsc_queue.hh"
+#include "bench_util.hh"
+
+using namespace SpeechTools::Bench;
+
+namespace {
+
+constexpr size_t kElements = 20'000'000;
+constexpr size_t kCapacity = 1024;
+
+// Pinned to the non-parking policy so the publish fence does not hide the
+// difference between single and batch publishes.
+using IntQueue = BasicSPSCLockFreeQueue<int, SPSCIndexing::kModulo, SPSCNoStats,
+                                        SPSCBlocking::kYield>;
+
+double runSingle() {
+  IntQueue q(kCapacity);
+  return timeIt([&] {
+    std::thread consumer([&] {
+      int v;
+      for (size_t i = 0; i < kElements; ++i) {
+        while (!q.try_pop(v)) {
+        }
+      }
+    });
+    for (size_t i = 0; i < kElements; ++i) {
+      while (!q.try_push(static_cast<int>(i))) {
+      }
+    }
+    consumer.join();
+  });
+}
+
+double runBatch(size_t batch) {
+  IntQueue q(kCapacity);
+  return timeIt([&] {
+    std::thread consumer([&] {
+      std::vector<int> out(batch);
+      for (size_t popped = 0; popped < kElements;) {
+        popped += q.try_pop_n(out);
+      }
+    });
+    std::vector<int> in(batch);
+    for (size_t pushed = 0; pushed < kElements;) {
+      size_t n = std::min(batch, kElements - pushed);
+      for (size_t j = 0; j < n; ++j) {
+        in[j] = static_cast<int>(pushed + j);
+      }
+      for (size_t done = 0; done < n;) {
+        done += q.try_push_n(in.begin() + done, n - done);
+      }
+      pushed += n;
+    }
+    consumer.join();
+  });
+}
+
+}  // namespace
+
+int main() {
+  report("spsc_single", "try_push/pop", kElements, runSingle());
+  for (size_t batch = 1; batch <= 64; batch *= 2) {
+    report("spsc_batch", "n=" + std::to_string(batch), kElements,
+           runBatch(batch));
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+// Compares the modulo (division) indexing path of SPSCLockFreeQueue with the
+// power-of-two mask path. The single-threaded loop isolates the per-operation
+// index arithmetic; the two-thread run shows the effect under real transfer.
+
+#include <thread>
+
+#include "../src/spsc_queue.hh"
+#include "bench_util.hh"
+
+using namespace SpeechTools::Bench;
+
+namespace {
+
+constexpr size_t kOps = 50'000'000;
+// Deliberately not a power of two, so the modulo path cannot be strength
+// reduced and the mask path rounds up to 1024.
+constexpr size_t kCapacity = 1000;
+
+template <typename Queue>
+double runLocal() {
+  Queue q(kCapacity);
+  size_t sink = 0;
+  double seconds = timeIt([&] {
+    size_t v = 0;
+    for (size_t i = 0; i < kOps; ++i) {
+      q.try_push(i);
+      q.try_pop(v);
+      sink += v;
+    }
+  });
+  // Keep the loop from being optimised away.
+  if (sink == 42) {
+    std::printf("\n");
+  }
+  return seconds;
+}
+
+template <typename Queue>
+double runThreaded() {
+  Queue q(kCapacity);
+  return timeIt([&] {
+    std::thread consumer([&] {
+      pinToCore(1);
+      size_t v;
+      for (size_t i = 0; i < kOps; ++i) {
+        while (!q.try_pop(v)) {
+        }
+      }
+    });
+    pinToCore(0);
+    for (size_t i = 0; i < kOps; ++i) {
+      while (!q.try_push(i)) {
+      }
+    }
+    consumer.join();
+  });
+}
+
+}  // namespace
+
+int main() {
+  // Pinned to the non-parking policy so the publish fence does not hide the
+  // indexing cost.
+  using ModuloQueue = BasicSPSCLockFreeQueue<size_t, SPSCIndexing::kModulo,
+                                             SPSCNoStats, SPSCBlocking::kYield>;
+  using MaskQueue = BasicSPSCLockFreeQueue<size_t, SPSCIndexing::kPowerOfTwo,
+                                           SPSCNoStats, SPSCBlocking::kYield>;
+  report("index_local", "modulo", kOps, runLocal<ModuloQueue>(), "push+pop");
+  report("index_local", "mask", kOps, runLocal<MaskQueue>(), "push+pop");
+  report("index_threaded", "modulo", kOps, runThreaded<ModuloQueue>(), "ops");
+  report("index_threaded", "mask", kOps, runThreaded<MaskQueue>(), "ops");
+  return 0;
+}
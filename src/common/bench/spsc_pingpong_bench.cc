@@ -0,0 +1,146 @@
+// Two-core producer/consumer benchmark for SPSCLockFreeQueue against a
+// reference queue with the original layout: head and tail adjacent on one
+// cache line and an acquire load of the opposite index on every operation.
+// Reports streaming throughput and round-trip (echo) rate, for the default
+// queue (no fence) and SPSCParkingQueue (a store-load fence per publish), plus
+// a single-thread push/pop loop that isolates the per-operation cost.
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "../src/spsc_queue.hh"
+#include "bench_util.hh"
+
+using namespace SpeechTools::Bench;
+
+namespace {
+
+constexpr size_t kStreamOps = 20'000'000;
+constexpr size_t kEchoOps = 1'000'000;
+constexpr size_t kLoopOps = 50'000'000;
+constexpr size_t kCapacity = 1024;
+
+// The queue as it was before the producer/consumer state split.
+template <typename T>
+class SharedLineQueue {
+ public:
+  explicit SharedLineQueue(size_t capacity)
+      : capacity_(capacity), buffer_(std::make_unique<T[]>(capacity + 1)) {}
+
+  bool try_push(const T& value) {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    size_t next_tail = (current_tail + 1) % (capacity_ + 1);
+    if (next_tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    buffer_[current_tail] = value;
+    tail_.store(next_tail, std::memory_order_release);
+    return true;
+  }
+
+  bool try_pop(T& value) {
+    size_t current_head = head_.load(std::memory_order_relaxed);
+    if (current_head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = std::move(buffer_[current_head]);
+    head_.store((current_head + 1) % (capacity_ + 1),
+                std::memory_order_release);
+    return true;
+  }
+
+ private:
+  const size_t capacity_;
+  std::atomic<size_t> head_ = 0;
+  std::atomic<size_t> tail_ = 0;
+  std::unique_ptr<T[]> buffer_;
+};
+
+template <template <typename> class Queue>
+double runStream() {
+  Queue<size_t> q(kCapacity);
+  return timeIt([&] {
+    std::thread consumer([&] {
+      pinToCore(1);
+      size_t v;
+      for (size_t i = 0; i < kStreamOps; ++i) {
+        while (!q.try_pop(v)) {
+        }
+      }
+    });
+    pinToCore(0);
+    for (size_t i = 0; i < kStreamOps; ++i) {
+      while (!q.try_push(i)) {
+      }
+    }
+    consumer.join();
+  });
+}
+
+template <template <typename> class Queue>
+double runEcho() {
+  Queue<size_t> ping(kCapacity), pong(kCapacity);
+  return timeIt([&] {
+    std::thread echo([&] {
+      pinToCore(1);
+      size_t v;
+      for (size_t i = 0; i < kEchoOps; ++i) {
+        while (!ping.try_pop(v)) {
+        }
+        while (!pong.try_push(v)) {
+        }
+      }
+    });
+    pinToCore(0);
+    size_t v;
+    for (size_t i = 0; i < kEchoOps; ++i) {
+      while (!ping.try_push(i)) {
+      }
+      while (!pong.try_pop(v)) {
+      }
+    }
+    echo.join();
+  });
+}
+
+template <template <typename> class Queue>
+double runLoop() {
+  Queue<size_t> q(kCapacity);
+  size_t sum = 0;
+  double seconds = timeIt([&] {
+    size_t v = 0;
+    for (size_t i = 0; i < kLoopOps; ++i) {
+      q.try_push(i);
+      q.try_pop(v);
+      sum += v;
+    }
+  });
+  // Keeps the loop from being optimised away.
+  if (sum == 0) {
+    std::printf("unexpected sum\n");
+  }
+  return seconds;
+}
+
+}  // namespace
+
+int main() {
+  report("stream", "shared_line", kStreamOps, runStream<SharedLineQueue>(),
+         "ops");
+  report("stream", "split_cached", kStreamOps, runStream<SPSCLockFreeQueue>(),
+         "ops");
+  report("stream", "split_park", kStreamOps, runStream<SPSCParkingQueue>(),
+         "ops");
+  report("echo", "shared_line", kEchoOps, runEcho<SharedLineQueue>(),
+         "round-trips");
+  report("echo", "split_cached", kEchoOps, runEcho<SPSCLockFreeQueue>(),
+         "round-trips");
+  report("echo", "split_park", kEchoOps, runEcho<SPSCParkingQueue>(),
+         "round-trips");
+  report("loop", "split_cached", kLoopOps, runLoop<SPSCLockFreeQueue>(),
+         "ops");
+  report("loop", "split_park", kLoopOps, runLoop<SPSCParkingQueue>(), "ops");
+  return 0;
+}
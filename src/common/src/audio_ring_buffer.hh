@@ -0,0 +1,503 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Sample layout of an AudioRingBuffer.
+ */
+enum class AudioLayout {
+  // Frames are stored one after another, each holding one sample per channel.
+  kInterleaved,
+  // Each channel is stored in its own contiguous plane.
+  kPlanar,
+};
+
+/**
+ * @brief A Single-Producer, Single-Consumer (SPSC) lock-free ring of audio
+ * samples.
+ *
+ * Unlike SPSCLockFreeQueue of per-frame vectors, samples live in one
+ * contiguous allocation, and the producer and consumer exchange arbitrary
+ * numbers of frames (one sample per channel) through spans into that storage.
+ *
+ * The ring is followed by a mirror of its first max_block_frames frames. The
+ * producer keeps the mirror and the ring start in sync on commit, so any block
+ * of up to max_block_frames frames is contiguous from any position: reads and
+ * writes never straddle the wrap. This is the portable equivalent of
+ * double-mapping the buffer, at the cost of copying the frames that land in
+ * the mirrored region.
+ *
+ * The consumer can peek() a window and consume() a smaller hop, so
+ * overlapping analysis windows are read in place without copying.
+ *
+ * For use as a SpeechFilter queue, the ring also exposes ValueType,
+ * try_push() and try_pop() over channel-major frame blocks
+ * (`frame[channel][sample]`). Those copy samples in and out; try_pop() pops
+ * max_block_frames frames at a time. A SpeechFilter that reads the ring
+ * through an AudioWindowReader instead gets each window in place.
+ *
+ * @tparam T The sample type.
+ * @tparam Channels The number of channels per frame.
+ * @tparam Layout The sample layout, see AudioLayout.
+ */
+template <typename T, size_t Channels,
+          AudioLayout Layout = AudioLayout::kPlanar>
+class AudioRingBuffer {
+  static_assert(Channels > 0, "AudioRingBuffer needs at least one channel.");
+  static constexpr bool kPlanar = Layout == AudioLayout::kPlanar;
+
+ public:
+  using SampleType = T;
+  using ValueType = std::vector<std::vector<T>>;
+
+  /**
+   * @brief A contiguous view of a block of frames inside the ring.
+   * @tparam U T for write blocks, const T for read blocks.
+   */
+  template <typename U>
+  class BlockView {
+   public:
+    BlockView() = default;
+
+    /**
+     * @brief Returns the number of frames in the block.
+     * @return The frame count, zero for an empty (failed) block.
+     */
+    size_t frames() const { return frames_; }
+
+    /**
+     * @brief Checks if the block is empty.
+     * @return true if the block holds no frames.
+     */
+    bool empty() const { return frames_ == 0; }
+
+    /**
+     * @brief Accesses the samples of one channel (planar layout).
+     * @param channel The channel index.
+     * @return A span over frames() samples of the channel.
+     */
+    std::span<U> channel(size_t channel) const
+      requires kPlanar
+    {
+      return {base_ + channel * stride_, frames_};
+    }
+
+    /**
+     * @brief Accesses the interleaved samples (interleaved layout).
+     * @return A span over frames() * Channels samples.
+     */
+    std::span<U> samples() const
+      requires(!kPlanar)
+    {
+      return {base_, frames_ * Channels};
+    }
+
+    // The ring the block views, for AudioWindowReader.
+    using Ring = AudioRingBuffer;
+
+   private:
+    friend class AudioRingBuffer;
+
+    BlockView(U* base, size_t stride, size_t frames)
+        : base_(base), stride_(stride), frames_(frames) {}
+
+    U* base_ = nullptr;
+    size_t stride_ = 0;
+    size_t frames_ = 0;
+  };
+
+  using WriteBlock = BlockView<T>;
+  using ReadBlock = BlockView<const T>;
+
+  /**
+   * @brief Constructs an audio ring buffer.
+   * @param capacity_frames The maximum number of frames the ring can hold.
+   * @param max_block_frames The largest block that can be written or read in
+   * one contiguous span. Also the size of the mirrored region.
+   * @throws std::runtime_error If either size is zero or max_block_frames
+   * exceeds capacity_frames.
+   */
+  AudioRingBuffer(size_t capacity_frames, size_t max_block_frames)
+      : capacity_(capacity_frames),
+        max_block_(max_block_frames),
+        stride_(capacity_frames + max_block_frames),
+        samples_(std::make_unique<T[]>(Channels * stride_)) {
+    if (capacity_frames == 0 || max_block_frames == 0) {
+      throw std::runtime_error("AudioRingBuffer sizes cannot be zero.");
+    }
+    if (max_block_frames > capacity_frames) {
+      throw std::runtime_error(
+          "AudioRingBuffer block size cannot exceed its capacity.");
+    }
+  }
+
+  AudioRingBuffer(const AudioRingBuffer&) = delete;
+  AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+  AudioRingBuffer(AudioRingBuffer&&) = delete;
+  AudioRingBuffer& operator=(AudioRingBuffer&&) = delete;
+
+  /**
+   * @brief Reserves space for frames to be written in place (producer).
+   * @param frames The number of frames to write, at most max_block_frames().
+   * @return A block of exactly frames frames, or an empty block if there is
+   * not enough free space.
+   */
+  WriteBlock prepare_write(size_t frames) {
+    size_t current_write = write_.load(std::memory_order_relaxed);
+    if (frames == 0 || frames > max_block_) {
+      return {};
+    }
+    if (capacity_ - fill(cached_read_, current_write) < frames) {
+      cached_read_ = read_.load(std::memory_order_acquire);
+      if (capacity_ - fill(cached_read_, current_write) < frames) {
+        return {};  // Not enough space
+      }
+    }
+    return {frame_ptr(position(current_write)), stride_, frames};
+  }
+
+  /**
+   * @brief Publishes frames written into the last prepare_write() block.
+   * @param frames The number of frames to publish, at most the prepared count.
+   */
+  void commit_write(size_t frames) {
+    size_t current_write = write_.load(std::memory_order_relaxed);
+    sync_mirror(position(current_write), frames);
+    write_.store(advance(current_write, frames), std::memory_order_release);
+  }
+
+  /**
+   * @brief Accesses the oldest frames in place without consuming them
+   * (consumer).
+   * @param frames The number of frames to view, at most max_block_frames().
+   * @return A block of exactly frames frames, or an empty block if fewer are
+   * available.
+   */
+  ReadBlock peek(size_t frames) {
+    size_t current_read = read_.load(std::memory_order_relaxed);
+    if (frames == 0 || frames > max_block_) {
+      return {};
+    }
+    if (fill(current_read, cached_write_) < frames) {
+      cached_write_ = write_.load(std::memory_order_acquire);
+      if (fill(current_read, cached_write_) < frames) {
+        return {};  // Not enough data
+      }
+    }
+    return {frame_ptr(position(current_read)), stride_, frames};
+  }
+
+  /**
+   * @brief Drops the oldest frames, handing their space back to the producer.
+   * @param frames The number of frames to drop, at most size().
+   */
+  void consume(size_t frames) {
+    size_t current_read = read_.load(std::memory_order_relaxed);
+    read_.store(advance(current_read, frames), std::memory_order_release);
+  }
+
+  /**
+   * @brief Checks whether a channel-major frame block can ever be pushed: it
+   * has Channels equally sized channels of at most max_block_frames()
+   * samples.
+   * @param frame The block, indexed as frame[channel][sample].
+   * @return true if the block has the right shape.
+   */
+  bool accepts(const ValueType& frame) const {
+    size_t frames = frame.empty() ? 0 : frame[0].size();
+    return frame.size() == Channels && frames <= max_block_ &&
+           std::all_of(frame.begin(), frame.end(),
+                       [&](const auto& ch) { return ch.size() == frames; });
+  }
+
+  /**
+   * @brief Attempts to copy a channel-major frame block into the ring.
+   *
+   * Like every queue's try_push(), it never throws, so a malformed block
+   * cannot terminate an audio thread: it is rejected like a block that does
+   * not fit. Producers that may build one should check accepts() first, since
+   * retrying it never succeeds.
+   * @param frame The block, indexed as frame[channel][sample].
+   * @return true if the block was written, false if there is not enough space
+   * or accepts() is false for it.
+   */
+  bool try_push(const ValueType& frame) {
+    if (!accepts(frame)) {
+      return false;
+    }
+    size_t frames = frame.empty() ? 0 : frame[0].size();
+    if (frames == 0) {
+      return true;
+    }
+
+    WriteBlock block = prepare_write(frames);
+    if (block.empty()) {
+      return false;
+    }
+    for (size_t c = 0; c < Channels; ++c) {
+      if constexpr (kPlanar) {
+        std::copy(frame[c].begin(), frame[c].end(), block.channel(c).begin());
+      } else {
+        std::span<T> out = block.samples();
+        for (size_t i = 0; i < frames; ++i) {
+          out[i * Channels + c] = frame[c][i];
+        }
+      }
+    }
+    commit_write(frames);
+    return true;
+  }
+
+  /**
+   * @brief Attempts to pop max_block_frames() frames into a channel-major
+   * frame block.
+   * @param frame The destination, resized to Channels x max_block_frames().
+   * Existing storage is reused.
+   * @return true if a block was popped, false if not enough frames are
+   * available.
+   */
+  bool try_pop(ValueType& frame) {
+    ReadBlock block = peek(max_block_);
+    if (block.empty()) {
+      return false;
+    }
+    frame.resize(Channels);
+    for (size_t c = 0; c < Channels; ++c) {
+      frame[c].resize(max_block_);
+      if constexpr (kPlanar) {
+        std::span<const T> in = block.channel(c);
+        std::copy(in.begin(), in.end(), frame[c].begin());
+      } else {
+        std::span<const T> in = block.samples();
+        for (size_t i = 0; i < max_block_; ++i) {
+          frame[c][i] = in[i * Channels + c];
+        }
+      }
+    }
+    consume(max_block_);
+    return true;
+  }
+
+  /**
+   * @brief Returns the approximate number of frames available to read.
+   * @return The number of buffered frames.
+   */
+  size_t size() const {
+    return fill(read_.load(std::memory_order_acquire),
+                write_.load(std::memory_order_acquire));
+  }
+
+  /**
+   * @brief Checks if the ring holds no frames.
+   * @return true if the ring is empty.
+   */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Checks if the ring has no free frames.
+   * @return true if the ring is full.
+   */
+  bool full() const { return size() == capacity_; }
+
+  /**
+   * @brief Returns the maximum number of frames the ring can hold.
+   * @return The capacity in frames.
+   */
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * @brief Returns the largest contiguous block size.
+   * @return The maximum frames per prepare_write()/peek() block.
+   */
+  size_t max_block_frames() const { return max_block_; }
+
+ private:
+  // Read and write counters run over [0, 2 * capacity_), so a full ring and an
+  // empty ring have different counter values while every frame stays usable,
+  // and no division is needed to wrap them.
+
+  /**
+   * @brief Calculates the number of buffered frames between two counters.
+   * @param read The read counter.
+   * @param write The write counter.
+   * @return The number of frames between read and write.
+   */
+  size_t fill(size_t read, size_t write) const {
+    return write >= read ? write - read : 2 * capacity_ + write - read;
+  }
+
+  /**
+   * @brief Advances a counter by a number of frames.
+   * @param counter The read or write counter.
+   * @param frames The number of frames to advance by.
+   * @return The advanced counter, wrapped into [0, 2 * capacity_).
+   */
+  size_t advance(size_t counter, size_t frames) const {
+    counter += frames;
+    return counter >= 2 * capacity_ ? counter - 2 * capacity_ : counter;
+  }
+
+  /**
+   * @brief Maps a counter onto its frame position in the ring.
+   * @param counter The read or write counter.
+   * @return The frame position in [0, capacity_).
+   */
+  size_t position(size_t counter) const {
+    return counter >= capacity_ ? counter - capacity_ : counter;
+  }
+
+  /**
+   * @brief Returns a pointer to the first sample of a frame position.
+   * @param pos A frame position in [0, capacity_ + max_block_).
+   * @return The address of channel 0 of that frame.
+   */
+  T* frame_ptr(size_t pos) {
+    return samples_.get() + (kPlanar ? pos : pos * Channels);
+  }
+
+  /**
+   * @brief Copies frames between positions, across all channels.
+   * @param from The source frame position.
+   * @param to The destination frame position.
+   * @param frames The number of frames to copy.
+   */
+  void copy_frames(size_t from, size_t to, size_t frames) {
+    if constexpr (kPlanar) {
+      for (size_t c = 0; c < Channels; ++c) {
+        T* plane = samples_.get() + c * stride_;
+        std::copy_n(plane + from, frames, plane + to);
+      }
+    } else {
+      std::copy_n(frame_ptr(from), frames * Channels, frame_ptr(to));
+    }
+  }
+
+  /**
+   * @brief Keeps the ring start and the mirror after it identical for a block
+   * that was just written.
+   * @param pos The frame position the block was written at.
+   * @param frames The number of frames written.
+   */
+  void sync_mirror(size_t pos, size_t frames) {
+    size_t end = pos + frames;
+    // Frames written past the ring end wrap to its start.
+    if (end > capacity_) {
+      size_t from = std::max(pos, capacity_);
+      copy_frames(from, from - capacity_, end - from);
+    }
+    // Frames written at the ring start are mirrored past its end.
+    if (pos < max_block_) {
+      copy_frames(pos, pos + capacity_, std::min(end, max_block_) - pos);
+    }
+  }
+
+  static constexpr size_t kCacheLineSize = 64;
+
+  // Read-only after construction and shared by both threads.
+  const size_t capacity_;
+  const size_t max_block_;
+  // Frames per channel plane: the ring plus its mirror.
+  const size_t stride_;
+  std::unique_ptr<T[]> samples_;
+
+  // Consumer-owned state.
+  alignas(kCacheLineSize) std::atomic<size_t> read_ = 0;
+  size_t cached_write_ = 0;
+
+  // Producer-owned state.
+  alignas(kCacheLineSize) std::atomic<size_t> write_ = 0;
+  size_t cached_read_ = 0;
+};
+
+/**
+ * @brief The consumer side of an AudioRingBuffer as a queue of analysis
+ * windows read in place, for use as a SpeechFilter input queue.
+ *
+ * peek() views the oldest window_frames frames inside the ring, contiguous
+ * thanks to its mirrored region, and release() consumes hop_frames of them.
+ * With a hop smaller than the window, consecutive windows overlap and every
+ * frame is read without a copy. This makes the reader a PeekQueue of
+ * ReadBlocks, so a SpeechFilter over it processes each window straight from
+ * the ring, e.g. SpeechFilter<Ring::ReadBlock, Out, Queue, FilterNoTelemetry,
+ * AudioWindowReader>.
+ *
+ * A window is a view and is only valid until release(), so it cannot be
+ * popped by value: filters reading it must process one frame at a time.
+ *
+ * @tparam Block The ReadBlock type of the ring to read.
+ */
+template <typename Block>
+class AudioWindowReader {
+  using Ring = typename Block::Ring;
+
+ public:
+  using ValueType = Block;
+
+  /**
+   * @brief Creates a reader; it is the ring's only consumer.
+   * @param ring The ring to read.
+   * @param window_frames The frames per window, at most
+   * ring.max_block_frames().
+   * @param hop_frames The frames consumed per window, at most window_frames.
+   * @throws std::runtime_error If a size is zero or out of range.
+   */
+  AudioWindowReader(Ring& ring, size_t window_frames, size_t hop_frames)
+      : ring_(ring), window_frames_(window_frames), hop_frames_(hop_frames) {
+    if (window_frames == 0 || window_frames > ring.max_block_frames()) {
+      throw std::runtime_error(
+          "AudioWindowReader window must fit in one ring block.");
+    }
+    if (hop_frames == 0 || hop_frames > window_frames) {
+      throw std::runtime_error(
+          "AudioWindowReader hop must be between one frame and the window.");
+    }
+  }
+
+  AudioWindowReader(const AudioWindowReader&) = delete;
+  AudioWindowReader& operator=(const AudioWindowReader&) = delete;
+
+  /**
+   * @brief Views the oldest window in place (consumer).
+   * @return The window, valid until release(), or nullptr if fewer than
+   * window_frames() frames are buffered.
+   */
+  const Block* peek() {
+    window_ = ring_.peek(window_frames_);
+    return window_.empty() ? nullptr : &window_;
+  }
+
+  /**
+   * @brief Finishes with the window returned by the last peek() and consumes
+   * hop_frames() frames (consumer).
+   */
+  void release() { ring_.consume(hop_frames_); }
+
+  /**
+   * @brief Checks whether a whole window is buffered.
+   * @return true if peek() would return nullptr.
+   */
+  bool empty() const { return ring_.size() < window_frames_; }
+
+  /**
+   * @brief Returns the frames per window.
+   * @return The window size in frames.
+   */
+  size_t window_frames() const { return window_frames_; }
+
+  /**
+   * @brief Returns the frames consumed per window.
+   * @return The hop size in frames.
+   */
+  size_t hop_frames() const { return hop_frames_; }
+
+ private:
+  Ring& ring_;
+  const size_t window_frames_;
+  const size_t hop_frames_;
+  Block window_;
+};
@@ -0,0 +1,352 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief What the writer of a SPMCBroadcastRing does when the slowest reader
+ * is a full ring behind.
+ */
+enum class BroadcastPolicy {
+  // try_push() fails until the slowest reader catches up.
+  kBlockOnSlowest,
+  // The oldest element is overwritten; readers that had not read it skip
+  // ahead and count the elements they missed in dropped(). If a reader is
+  // reading the oldest element right then, the new element is dropped
+  // instead and counted for every reader.
+  kOverwriteLaggard,
+};
+
+/**
+ * @brief A bounded Single-Producer, Multi-Consumer broadcast ring.
+ *
+ * The producer writes each element once and every reader sees every element
+ * (unless dropped under kOverwriteLaggard), each through its own read cursor.
+ * This replaces copying every frame into one SPSCLockFreeQueue per downstream
+ * filter. Readers are fixed at construction and accessed with reader(i); each
+ * Reader must only be used by one thread. A SpeechFilter consumes one branch
+ * by reading from a Reader: pass BroadcastReader, or LaggardBroadcastReader
+ * for a kOverwriteLaggard ring, as its InQueueType. It reads each element in
+ * place through peek()/release(), so N branches share one copy of a frame;
+ * try_pop() copies the element out for other consumers.
+ *
+ * Slots hold live elements that readers copy out (try_pop) or inspect in place
+ * (peek/release), so T must be default constructible and copy assignable.
+ * The capacity is rounded up to a power of two.
+ *
+ * With kOverwriteLaggard, a reader marks its cursor busy while it reads a
+ * slot, so the writer never overwrites an element that is being read. It
+ * never waits for that read either, so a real-time writer cannot livelock on
+ * a reader sharing its core.
+ *
+ * @tparam T The element type.
+ * @tparam Policy The full-ring behaviour, see BroadcastPolicy.
+ */
+template <typename T, BroadcastPolicy Policy = BroadcastPolicy::kBlockOnSlowest>
+class SPMCBroadcastRing {
+  static constexpr bool kOverwrite =
+      Policy == BroadcastPolicy::kOverwriteLaggard;
+  static constexpr size_t kCacheLineSize = 64;
+  // Set in a reader cursor while that reader accesses the slot it points to.
+  static constexpr size_t kBusy = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+  struct alignas(kCacheLineSize) ReaderState {
+    // Position of the next element to read; only the owning reader and, under
+    // kOverwriteLaggard, the writer change it.
+    std::atomic<size_t> cursor = 0;
+    // Elements skipped because the writer overwrote them.
+    std::atomic<uint64_t> dropped = 0;
+    // The reader's last observed value of tail_.
+    size_t cached_tail = 0;
+  };
+
+ public:
+  using ValueType = T;
+
+  /**
+   * @brief A reader's view of the ring. Obtained from reader(); not copyable.
+   */
+  class Reader {
+   public:
+    using ValueType = T;
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /**
+     * @brief Attempts to copy out the next element (non-blocking).
+     * @param value A reference to store the element.
+     * @return true if an element was read, false if this reader is caught up.
+     */
+    bool try_pop(T& value) {
+      const T* front = peek();
+      if (front == nullptr) {
+        return false;
+      }
+      value = *front;
+      release();
+      return true;
+    }
+
+    /**
+     * @brief Accesses the next element in place (non-blocking).
+     *
+     * The element stays valid until release() is called, which must happen
+     * before the next peek().
+     * @return A pointer to the next element, or nullptr if this reader is
+     * caught up.
+     */
+    const T* peek() {
+      size_t pos = state_.cursor.load(std::memory_order_acquire);
+      for (;;) {
+        // The writer may have moved the cursor past the cached tail.
+        if (pos >= state_.cached_tail) {
+          state_.cached_tail = ring_.tail_.load(std::memory_order_acquire);
+          if (pos == state_.cached_tail) {
+            return nullptr;  // Caught up
+          }
+        }
+        if constexpr (!kOverwrite) {
+          break;
+        } else if (state_.cursor.compare_exchange_weak(
+                       pos, pos | kBusy, std::memory_order_acquire)) {
+          break;
+        }
+        // The writer moved this cursor past overwritten elements; pos now
+        // holds the new position.
+      }
+      reading_ = pos;
+      return &ring_.slots_[pos & ring_.mask_];
+    }
+
+    /**
+     * @brief Finishes with the element returned by the last peek().
+     */
+    void release() {
+      state_.cursor.store(reading_ + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Returns how many elements this reader missed because the writer
+     * overwrote them (kOverwriteLaggard only).
+     * @return The cumulative dropped element count.
+     */
+    uint64_t dropped() const {
+      return state_.dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the approximate number of elements this reader has not
+     * read yet.
+     * @return The reader's backlog.
+     */
+    size_t size() const {
+      size_t pos = state_.cursor.load(std::memory_order_acquire) & ~kBusy;
+      size_t tail = ring_.tail_.load(std::memory_order_acquire);
+      return tail > pos ? std::min(tail - pos, ring_.capacity_) : 0;
+    }
+
+    /**
+     * @brief Checks if this reader is caught up.
+     * @return true if there is nothing left to read.
+     */
+    bool empty() const { return size() == 0; }
+
+   private:
+    friend class SPMCBroadcastRing;
+
+    Reader(SPMCBroadcastRing& ring, ReaderState& state)
+        : ring_(ring), state_(state) {}
+
+    SPMCBroadcastRing& ring_;
+    ReaderState& state_;
+    // Position handed out by the last peek().
+    size_t reading_ = 0;
+  };
+
+  /**
+   * @brief Constructs a broadcast ring.
+   * @param capacity The number of elements buffered for the slowest reader,
+   * rounded up to a power of two.
+   * @param readers The number of independent readers.
+   * @throws std::runtime_error If capacity or readers is zero.
+   */
+  SPMCBroadcastRing(size_t capacity, size_t readers) {
+    if (capacity == 0 || readers == 0) {
+      throw std::runtime_error(
+          "SPMCBroadcastRing capacity and reader count cannot be zero.");
+    }
+    if (capacity > (SIZE_MAX >> 2)) {
+      throw std::runtime_error("SPMCBroadcastRing capacity too large.");
+    }
+    capacity_ = std::bit_ceil(capacity);
+    mask_ = capacity_ - 1;
+    slots_ = std::make_unique<T[]>(capacity_);
+    states_ = std::make_unique<ReaderState[]>(readers);
+    readers_.reserve(readers);
+    for (size_t i = 0; i < readers; ++i) {
+      readers_.emplace_back(new Reader(*this, states_[i]));
+    }
+  }
+
+  SPMCBroadcastRing(const SPMCBroadcastRing&) = delete;
+  SPMCBroadcastRing& operator=(const SPMCBroadcastRing&) = delete;
+  SPMCBroadcastRing(SPMCBroadcastRing&&) = delete;
+  SPMCBroadcastRing& operator=(SPMCBroadcastRing&&) = delete;
+
+  /**
+   * @brief Returns one of the readers.
+   * @param index The reader index, below reader_count().
+   * @return The reader, to be used by a single consumer thread.
+   */
+  Reader& reader(size_t index) { return *readers_.at(index); }
+
+  /**
+   * @brief Returns the number of readers.
+   * @return The reader count given at construction.
+   */
+  size_t reader_count() const { return readers_.size(); }
+
+  /**
+   * @brief Attempts to publish an element to all readers (non-blocking, copy).
+   * @param value The element to copy into the ring.
+   * @return true if the element was published. Always true under
+   * kOverwriteLaggard, even when the element had to be dropped; false under
+   * kBlockOnSlowest if the slowest reader is a full ring behind.
+   */
+  bool try_push(const T& value) { return publish(value); }
+
+  /**
+   * @brief Attempts to publish an element to all readers (non-blocking, move).
+   * @param value The element to move into the ring. Left untouched on failure.
+   * @return true if the element was published, see try_push(const T&).
+   */
+  bool try_push(T&& value) { return publish(std::move(value)); }
+
+  /**
+   * @brief Returns the maximum number of elements buffered per reader.
+   * @return The capacity, after power-of-two rounding.
+   */
+  size_t capacity() const { return capacity_; }
+
+ private:
+  /**
+   * @brief Writes an element into the next slot once every reader is done
+   * with it.
+   * @param value The element to copy or move into the ring.
+   * @return true if the element was written.
+   */
+  template <typename U>
+  bool publish(U&& value) {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    if (current_tail - cached_min_cursor_ >= capacity_) {
+      cached_min_cursor_ = min_cursor();
+      if (current_tail - cached_min_cursor_ >= capacity_) {
+        if constexpr (kOverwrite) {
+          if (!evict_laggards(current_tail + 1 - capacity_)) {
+            // A reader is reading the slot; every reader misses this element.
+            for (size_t i = 0; i < readers_.size(); ++i) {
+              count_dropped(states_[i], 1);
+            }
+            return true;
+          }
+        } else {
+          return false;  // The slowest reader has not read this slot yet
+        }
+      }
+    }
+
+    slots_[current_tail & mask_] = std::forward<U>(value);
+    tail_.store(current_tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Returns the position of the slowest reader.
+   * @return The smallest reader cursor.
+   */
+  size_t min_cursor() const {
+    size_t min = SIZE_MAX;
+    for (size_t i = 0; i < readers_.size(); ++i) {
+      min = std::min(min, states_[i].cursor.load(std::memory_order_acquire) &
+                              ~kBusy);
+    }
+    return min;
+  }
+
+  /**
+   * @brief Moves every reader behind oldest forward to it, counting the
+   * skipped elements. Never waits.
+   * @param oldest The oldest position that stays readable after the push.
+   * @return true if the slot before oldest is free to overwrite, false if a
+   * reader is reading it right now. Readers already moved stay moved.
+   */
+  bool evict_laggards(size_t oldest) {
+    for (size_t i = 0; i < readers_.size(); ++i) {
+      ReaderState& state = states_[i];
+      size_t pos = state.cursor.load(std::memory_order_acquire);
+      while ((pos & ~kBusy) < oldest) {
+        if (pos & kBusy) {
+          return false;  // The reader is copying out the slot
+        }
+        if (state.cursor.compare_exchange_weak(pos, oldest,
+                                               std::memory_order_acq_rel)) {
+          count_dropped(state, oldest - pos);
+          break;
+        }
+      }
+    }
+    cached_min_cursor_ = oldest;
+    return true;
+  }
+
+  /**
+   * @brief Adds to a reader's dropped count (writer).
+   * @param state The reader.
+   * @param count The number of elements it missed.
+   */
+  static void count_dropped(ReaderState& state, size_t count) {
+    state.dropped.store(state.dropped.load(std::memory_order_relaxed) + count,
+                        std::memory_order_relaxed);
+  }
+
+  // Read-only after construction.
+  size_t capacity_ = 0;
+  size_t mask_ = 0;
+  std::unique_ptr<T[]> slots_;
+  std::unique_ptr<ReaderState[]> states_;
+  std::vector<std::unique_ptr<Reader>> readers_;
+
+  // Producer-owned state: the write position and the last observed position
+  // of the slowest reader.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_ = 0;
+  size_t cached_min_cursor_ = 0;
+};
+
+/**
+ * @brief A reader of an SPMCBroadcastRing<T, Policy>.
+ */
+template <typename T, BroadcastPolicy Policy = BroadcastPolicy::kBlockOnSlowest>
+using BasicBroadcastReader = typename SPMCBroadcastRing<T, Policy>::Reader;
+
+/**
+ * @brief A reader of an SPMCBroadcastRing<T> with the default
+ * kBlockOnSlowest policy, usable as a single-parameter queue template such as
+ * SpeechFilter's InQueueType.
+ */
+template <typename T>
+using BroadcastReader = BasicBroadcastReader<T>;
+
+/**
+ * @brief A reader of a kOverwriteLaggard SPMCBroadcastRing<T>, usable as a
+ * single-parameter queue template such as SpeechFilter's InQueueType.
+ */
+template <typename T>
+using LaggardBroadcastReader =
+    BasicBroadcastReader<T, BroadcastPolicy::kOverwriteLaggard>;
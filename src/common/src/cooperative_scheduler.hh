@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "filter_task.hh"
+
+namespace SpeechTools {
+
+/** @brief Runs filters synchronously on the caller's thread, for single-
+ * threaded (e.g. embedded) targets and deterministic tests.
+ *
+ * SpeechFilters constructed with a CooperativeScheduler start no thread;
+ * they only process input when the owner calls runOnce() or runUntilIdle().
+ * Each call gives every attached filter one bounded turn, in attach order, so
+ * a pipeline attached source to sink moves a frame all the way through in a
+ * single round, and results are reproducible without sleeps.
+ *
+ * Not thread-safe: attach, detach and run from one thread, and never from
+ * inside a filter's turn. The scheduler must outlive every filter attached to
+ * it.
+ */
+class CooperativeScheduler {
+ public:
+  CooperativeScheduler() = default;
+  CooperativeScheduler(const CooperativeScheduler&) = delete;
+  CooperativeScheduler& operator=(const CooperativeScheduler&) = delete;
+
+  /**
+   * @brief Adds a task to the end of the run order.
+   * @param task The task to run until it is detached.
+   */
+  void attach(FilterTask& task) { tasks_.push_back(&task); }
+
+  /**
+   * @brief Removes a task; it is not run again.
+   * @param task A task previously passed to attach().
+   */
+  void detach(FilterTask& task) {
+    tasks_.erase(std::remove(tasks_.begin(), tasks_.end(), &task),
+                 tasks_.end());
+  }
+
+  /**
+   * @brief Gives every attached task one turn, in attach order.
+   * @return true if any task made progress.
+   */
+  bool runOnce() {
+    bool progressed = false;
+    for (FilterTask* task : tasks_) {
+      progressed = task->run_(*task) || progressed;
+    }
+    return progressed;
+  }
+
+  /**
+   * @brief Runs rounds until one makes no progress, i.e. until every filter
+   * has processed all its input or is blocked on a full output queue.
+   * @return The number of rounds that made progress.
+   */
+  size_t runUntilIdle() {
+    size_t rounds = 0;
+    while (runOnce()) {
+      ++rounds;
+    }
+    return rounds;
+  }
+
+  /**
+   * @brief Returns the number of attached tasks.
+   * @return The task count.
+   */
+  size_t taskCount() const { return tasks_.size(); }
+
+ private:
+  std::vector<FilterTask*> tasks_;
+};
+
+}  // namespace SpeechTools
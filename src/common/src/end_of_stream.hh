@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include "frame_trace.hh"
+
+namespace SpeechTools {
+
+/** @brief Describes how a frame type marks the end of a stream, so that
+ * SpeechFilter::drain() can tell downstream filters that no more frames
+ * follow.
+ *
+ * The primary template has no marker; draining a filter whose output type has
+ * none still processes and flushes everything, but downstream filters must
+ * then be drained explicitly. Specialise it for a frame type by providing
+ * kSupported = true, a marker() frame and isMarker(). Specialisations are
+ * provided for std::optional (std::nullopt), std::unique_ptr such as
+ * FramePool::Frame (nullptr) and Traced envelopes of those.
+ *
+ * @tparam T The frame type.
+ */
+template <typename T>
+struct EndOfStream {
+  static constexpr bool kSupported = false;
+};
+
+template <typename T>
+struct EndOfStream<std::optional<T>> {
+  static constexpr bool kSupported = true;
+
+  static std::optional<T> marker() { return std::nullopt; }
+  static bool isMarker(const std::optional<T>& frame) {
+    return !frame.has_value();
+  }
+};
+
+template <typename T, typename Deleter>
+struct EndOfStream<std::unique_ptr<T, Deleter>> {
+  static constexpr bool kSupported = true;
+
+  static std::unique_ptr<T, Deleter> marker() { return nullptr; }
+  static bool isMarker(const std::unique_ptr<T, Deleter>& frame) {
+    return frame == nullptr;
+  }
+};
+
+template <typename T>
+  requires EndOfStream<T>::kSupported
+struct EndOfStream<Traced<T>> {
+  static constexpr bool kSupported = true;
+
+  static Traced<T> marker() { return {EndOfStream<T>::marker(), {}}; }
+  static bool isMarker(const Traced<T>& frame) {
+    return EndOfStream<T>::isMarker(frame.payload);
+  }
+};
+
+}  // namespace SpeechTools
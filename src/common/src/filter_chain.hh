@@ -0,0 +1,147 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#include "filter_executor.hh"
+#include "speech_filter.hh"
+#include "spsc_queue.hh"
+#include "wait_strategy.hh"
+
+namespace SpeechTools {
+
+// Concept for a lightweight processing stage that can be fused into a
+// FilterChain: it names its input and output types and has a public process().
+template <typename Stage>
+concept FilterStage = requires(Stage& stage,
+                               const typename Stage::InType& input) {
+  typename Stage::OutType;
+  {
+    stage.process(input)
+  } -> std::convertible_to<typename Stage::OutType>;
+};
+
+namespace detail {
+
+template <typename First, typename Second, typename... Rest>
+constexpr bool stagesConnect() {
+  if constexpr (!std::same_as<typename First::OutType,
+                              typename Second::InType>) {
+    return false;
+  } else if constexpr (sizeof...(Rest) == 0) {
+    return true;
+  } else {
+    return stagesConnect<Second, Rest...>();
+  }
+}
+
+template <typename... Stages>
+struct ChainTypes {
+  using Tuple = std::tuple<Stages...>;
+  using First = std::tuple_element_t<0, Tuple>;
+  using Last = std::tuple_element_t<sizeof...(Stages) - 1, Tuple>;
+};
+
+// Holds the stages in a base class that is constructed before SpeechFilter,
+// so they exist before the filter thread can call process().
+template <typename... Stages>
+struct ChainStages {
+  std::tuple<Stages...> stages;
+};
+
+}  // namespace detail
+
+// Concept for a sequence of stages where each stage's OutType is the next
+// stage's InType.
+template <typename... Stages>
+concept ChainableStages =
+    sizeof...(Stages) > 0 && (FilterStage<Stages> && ...) &&
+    (sizeof...(Stages) == 1 || detail::stagesConnect<Stages...>());
+
+/** @brief A SpeechFilter that runs several stages back to back on its own
+ * thread, without a queue or thread per hop.
+ *
+ * process() calls each stage's process() directly and hands the result to the
+ * next stage, so intermediate frames stay in cache and never cross a queue.
+ * Use it for cheap stages whose queue hop would cost more than their work.
+ * The stage types are checked at compile time: each stage's OutType must be
+ * the next stage's InType.
+ *
+ * Stages are a separate, lightweight API (FilterStage), not SpeechFilters: a
+ * SpeechFilter such as NoiseFilter owns a thread or executor slot and its
+ * queues, so it cannot be fused as it is. Write processing that should be
+ * fusable as a stage; a single-stage FilterChain then runs it as a standalone
+ * filter too.
+ *
+ * @tparam QueueType The queue template of the chain's input and output.
+ * @tparam Stages The FilterStage types, in processing order.
+ */
+template <template <typename> class QueueType, typename... Stages>
+  requires ChainableStages<Stages...>
+class BasicFilterChain
+    : private detail::ChainStages<Stages...>,
+      public SpeechFilter<
+          typename detail::ChainTypes<Stages...>::First::InType,
+          typename detail::ChainTypes<Stages...>::Last::OutType,
+          QueueType> {
+  using Holder = detail::ChainStages<Stages...>;
+
+ public:
+  using InType = typename detail::ChainTypes<Stages...>::First::InType;
+  using OutType = typename detail::ChainTypes<Stages...>::Last::OutType;
+  using Base = SpeechFilter<InType, OutType, QueueType>;
+
+  BasicFilterChain(QueueType<InType>& in, QueueType<OutType>& out,
+                   Stages... stages)
+      : Holder{{std::move(stages)...}}, Base(in, out) {}
+
+  BasicFilterChain(QueueType<InType>& in, QueueType<OutType>& out,
+                   WaitStrategy wait, Stages... stages)
+      : Holder{{std::move(stages)...}}, Base(in, out, wait) {}
+
+  // Like any pooled SpeechFilter, the chain is created stopped; call start(),
+  // or create it as a ScopedFilter.
+  BasicFilterChain(QueueType<InType>& in, QueueType<OutType>& out,
+                   FilterExecutor& executor, Stages... stages)
+      : Holder{{std::move(stages)...}}, Base(in, out, executor) {}
+
+  /**
+   * @brief Accesses one stage, e.g. to read its state after a run.
+   * @tparam I The stage index.
+   * @return The stage.
+   */
+  template <size_t I>
+  auto& stage() {
+    return std::get<I>(this->stages);
+  }
+
+ protected:
+  OutType process(const InType& input_data) override {
+    return runFrom<0>(input_data);
+  }
+
+ private:
+  /**
+   * @brief Runs stage I and every stage after it.
+   * @param value The input of stage I.
+   * @return The output of the last stage.
+   */
+  template <size_t I, typename Value>
+  OutType runFrom(const Value& value) {
+    if constexpr (I + 1 == sizeof...(Stages)) {
+      return std::get<I>(this->stages).process(value);
+    } else {
+      return runFrom<I + 1>(std::get<I>(this->stages).process(value));
+    }
+  }
+};
+
+/**
+ * @brief BasicFilterChain over SpeechFilter's default SPSCParkingQueue.
+ */
+template <typename... Stages>
+using FilterChain = BasicFilterChain<SPSCParkingQueue, Stages...>;
+
+}  // namespace SpeechTools
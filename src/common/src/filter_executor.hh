@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "filter_task.hh"
+#include "wait_strategy.hh"
+
+namespace SpeechTools {
+
+/** @brief A fixed pool of worker threads that runs many filters, instead of
+ * one thread per filter.
+ *
+ * Attached tasks (normally SpeechFilters) are spread round-robin over per-
+ * worker run queues. A worker takes the task at the front of its queue, lets
+ * it process a bounded amount of input, and puts it back at
+ * the end, so every filter with input gets a turn. A worker whose queue is
+ * empty steals a task from the back of another worker's queue, so tasks move
+ * towards idle workers. A task is only ever run by one worker at a time,
+ * which keeps SPSC queues between filters valid.
+ *
+ * Run queues only hold tasks that may have work. A task whose turn made no
+ * progress parks on the queue it waits for, when that queue can call a
+ * QueueWaker (e.g. SPSCParkingQueue, the filters' default): it leaves the run
+ * queues, and whichever thread next pushes into its empty input or pops from
+ * its full output puts it back, whether that is a pooled filter or code
+ * outside the pool. Idle parked filters cost the workers nothing.
+ *
+ * Tasks that cannot park, e.g. filters over SPSCLockFreeQueue, are polled
+ * instead. Workers that go a full round without progress back off like
+ * WaitStrategy::kPark and then sleep until woken, at most kIdleSleep per idle
+ * round, since a worker cannot wait on all of its filters' queues at once. A
+ * task that makes progress wakes sleeping workers, so data moving between
+ * pooled filters is picked up right away. Code feeding such a filter from
+ * outside the pool can call notify() after pushing to do the same; without it
+ * the filter runs within one idle sleep.
+ *
+ * The executor must outlive every task attached to it.
+ */
+class FilterExecutor {
+ public:
+  // Kept as a member name for code written against the executor.
+  using Task = FilterTask;
+
+  /**
+   * @brief Starts the worker threads.
+   * @param workers The number of workers, by default one per hardware thread.
+   * @throws std::runtime_error If workers is zero.
+   */
+  explicit FilterExecutor(
+      size_t workers = std::max(1u, std::thread::hardware_concurrency())) {
+    if (workers == 0) {
+      throw std::runtime_error("FilterExecutor needs at least one worker.");
+    }
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+      workers_.push_back(std::make_unique<Worker>());
+    }
+    running_ = true;
+    for (size_t i = 0; i < workers; ++i) {
+      workers_[i]->thread = std::thread([this, i] { workerLoop(i); });
+    }
+  }
+
+  /**
+   * @brief Stops and joins the workers. Tasks still attached are not run
+   * again.
+   */
+  ~FilterExecutor() {
+    running_ = false;
+    notify();
+    for (auto& worker : workers_) {
+      worker->thread.join();
+    }
+  }
+
+  FilterExecutor(const FilterExecutor&) = delete;
+  FilterExecutor& operator=(const FilterExecutor&) = delete;
+
+  /**
+   * @brief Adds a task to the pool (any thread).
+   * @param task The task to run until it is detached.
+   */
+  void attach(Task& task) {
+    task.detaching_ = false;
+    task.removed_ = false;
+    task.executor_ = this;
+    task.waker_ = QueueWaker{&FilterExecutor::wakeTask, &task};
+    {
+      std::lock_guard lock(park_mutex_);
+      task.parked_ = false;
+      task.woken_ = false;
+    }
+    enqueue(task);
+  }
+
+  /**
+   * @brief Removes a task from the pool, waiting for a worker that is running
+   * it to finish its current turn (any thread but a worker).
+   * @param task A task previously passed to attach().
+   */
+  void detach(Task& task) {
+    task.detaching_.store(true);
+    if (task.unpark_) {
+      // Also waits out a waker call that is putting the task back.
+      task.unpark_(task);
+    }
+    {
+      std::lock_guard lock(park_mutex_);
+      if (task.parked_) {
+        task.parked_ = false;
+        return;
+      }
+    }
+    for (auto& worker : workers_) {
+      std::lock_guard lock(worker->mutex);
+      auto it = std::find(worker->tasks.begin(), worker->tasks.end(), &task);
+      if (it != worker->tasks.end()) {
+        worker->tasks.erase(it);
+        return;
+      }
+    }
+    // A worker holds the task and drops it after the current turn. Poll
+    // rather than wait: the worker must not touch the task after setting
+    // removed_, since the caller may destroy it right away.
+    while (!task.removed_.load()) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Wakes workers sleeping after an idle round, e.g. after pushing
+   * into the input queue of a pooled filter (any thread).
+   *
+   * Costs one atomic increment, plus a lock and a notify when a worker is
+   * asleep.
+   */
+  void notify() {
+    // Pairs with idleWait(): either the worker sees the new epoch, or this
+    // sees the worker counted in sleepers_.
+    wake_epoch_.fetch_add(1);
+    if (sleepers_.load() > 0) {
+      std::lock_guard lock(idle_mutex_);
+      idle_cv_.notify_all();
+    }
+  }
+
+  /**
+   * @brief Returns the number of worker threads.
+   * @return The worker count.
+   */
+  size_t workerCount() const { return workers_.size(); }
+
+ private:
+  // Longest sleep of a worker that found no work in a full round of its
+  // tasks, in case nobody calls notify().
+  static constexpr std::chrono::microseconds kIdleSleep{200};
+
+  struct Worker {
+    std::mutex mutex;
+    // Tasks waiting for their next turn on this worker.
+    std::deque<Task*> tasks;
+    std::thread thread;
+  };
+
+  /**
+   * @brief Runs tasks from worker index's queue, stealing when it is empty.
+   * @param index The worker's position in workers_.
+   */
+  void workerLoop(size_t index) {
+    Worker& self = *workers_[index];
+    IdleBackoff idle(WaitStrategy::kPark);
+    // Consecutive runs without progress; a full round of them means idle.
+    size_t idle_runs = 0;
+    // wake_epoch_ when the current round started; a change means some task
+    // made progress or notify() was called since.
+    uint64_t epoch = 0;
+
+    while (running_.load(std::memory_order_relaxed)) {
+      if (idle_runs == 0) {
+        epoch = wake_epoch_.load();
+      }
+      size_t queued = 0;
+      Task* task = takeOwn(self, queued);
+      if (task == nullptr) {
+        task = steal(index);
+      }
+      if (task == nullptr) {
+        if (idle.pause()) {
+          idleWait(epoch);
+        }
+        continue;
+      }
+
+      if (task->run_(*task)) {
+        idle.reset();
+        idle_runs = 0;
+        // The task may have filled another filter's input.
+        notify();
+      } else if (task->park_ && park(*task)) {
+        continue;  // Off the run queues until its waker is called
+      } else if (++idle_runs > queued) {
+        // Back off once per full idle round, not once per idle task.
+        idle_runs = 0;
+        if (idle.pause()) {
+          idleWait(epoch);
+        }
+      }
+      requeue(self, *task);
+    }
+  }
+
+  /**
+   * @brief Puts a task on the run queue of the next worker, round-robin, and
+   * wakes sleeping workers.
+   * @param task The task.
+   */
+  void enqueue(Task& task) {
+    size_t index = next_worker_.fetch_add(1, std::memory_order_relaxed) %
+                   workers_.size();
+    Worker& worker = *workers_[index];
+    {
+      std::lock_guard lock(worker.mutex);
+      worker.tasks.push_back(&task);
+    }
+    notify();
+  }
+
+  /**
+   * @brief Parks a task whose turn made no progress, unless its waker was
+   * called meanwhile or it is being detached (worker).
+   * @param task The task, held by the calling worker.
+   * @return true if the task was parked or let go of for detach(), false if
+   * it has to be queued again.
+   */
+  bool park(Task& task) {
+    if (!task.park_(task, task.waker_)) {
+      return false;
+    }
+    {
+      std::lock_guard lock(park_mutex_);
+      if (task.woken_) {
+        task.woken_ = false;
+        return false;
+      }
+      if (!task.detaching_.load()) {
+        task.parked_ = true;
+        return true;
+      }
+    }
+    // detach() may have withdrawn the waker before park_ registered it.
+    task.unpark_(task);
+    task.removed_.store(true);
+    return true;
+  }
+
+  /**
+   * @brief The waker of every attached task: puts the task back on a run
+   * queue (the thread that ended the task's wait).
+   * @param context The task.
+   */
+  static void wakeTask(void* context) {
+    Task& task = *static_cast<Task*>(context);
+    FilterExecutor& executor = *task.executor_;
+    {
+      std::lock_guard lock(executor.park_mutex_);
+      if (!task.parked_) {
+        task.woken_ = true;  // Still being parked; park() queues it again
+        return;
+      }
+      task.parked_ = false;
+    }
+    executor.enqueue(task);
+  }
+
+  /**
+   * @brief Sleeps for at most kIdleSleep, unless notify() was called since
+   * epoch was read.
+   * @param epoch The wake_epoch_ value seen before the idle round.
+   */
+  void idleWait(uint64_t epoch) {
+    std::unique_lock lock(idle_mutex_);
+    sleepers_.fetch_add(1);
+    idle_cv_.wait_for(lock, kIdleSleep, [&] {
+      return wake_epoch_.load() != epoch || !running_.load();
+    });
+    sleepers_.fetch_sub(1);
+  }
+
+  /**
+   * @brief Takes the task at the front of a worker's own queue.
+   * @param self The worker.
+   * @param queued Set to the number of tasks left in the queue.
+   * @return The task, or nullptr if the queue is empty.
+   */
+  static Task* takeOwn(Worker& self, size_t& queued) {
+    std::lock_guard lock(self.mutex);
+    if (self.tasks.empty()) {
+      return nullptr;
+    }
+    Task* task = self.tasks.front();
+    self.tasks.pop_front();
+    queued = self.tasks.size();
+    return task;
+  }
+
+  /**
+   * @brief Takes a task from the back of another worker's queue, leaving
+   * every victim at least one task.
+   * @param thief The index of the stealing worker.
+   * @return The stolen task, or nullptr if there was nothing to steal.
+   */
+  Task* steal(size_t thief) {
+    for (size_t i = 1; i < workers_.size(); ++i) {
+      Worker& victim = *workers_[(thief + i) % workers_.size()];
+      std::lock_guard lock(victim.mutex);
+      if (victim.tasks.size() > 1) {
+        Task* task = victim.tasks.back();
+        victim.tasks.pop_back();
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Queues a task for its next turn, unless it is being detached.
+   * @param self The worker that ran the task.
+   * @param task The task.
+   */
+  static void requeue(Worker& self, Task& task) {
+    std::lock_guard lock(self.mutex);
+    if (task.detaching_.load()) {
+      task.removed_.store(true);
+    } else {
+      self.tasks.push_back(&task);
+    }
+  }
+
+  std::atomic<bool> running_ = false;
+  std::atomic<size_t> next_worker_ = 0;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  // Guards the parked_ and woken_ flags of every attached task.
+  std::mutex park_mutex_;
+
+  // Idle sleep state: bumped by notify(), and the number of workers asleep.
+  std::atomic<uint64_t> wake_epoch_ = 0;
+  std::atomic<size_t> sleepers_ = 0;
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+};
+
+}  // namespace SpeechTools
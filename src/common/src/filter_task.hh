@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+
+#include "queue_waker.hh"
+
+namespace SpeechTools {
+
+class CooperativeScheduler;
+class FilterExecutor;
+
+/** @brief A unit of work that a FilterExecutor or CooperativeScheduler runs
+ * repeatedly, normally a SpeechFilter.
+ *
+ * On a FilterExecutor, a worker may run the task from any thread as soon as
+ * it is attached, and until detach() returns, so everything the task's work
+ * touches must be fully constructed before attach() and outlive detach().
+ *
+ * Kept apart from both schedulers so that neither pulls in the other's
+ * headers.
+ */
+class FilterTask {
+ public:
+  // Does a bounded amount of work for a task without blocking; returns true
+  // if any progress was made, false if the task was idle.
+  using RunFn = bool (*)(FilterTask&);
+  // Called after a turn without progress: registers the waker with the
+  // queue the task waits for, e.g. with park_consumer(). Returns false if
+  // the task cannot park and has to be polled; may return true without a
+  // registration if the task has nothing left to wait for.
+  using ParkFn = bool (*)(FilterTask&, const QueueWaker&);
+  // Withdraws what ParkFn registered, e.g. with cancel_consumer_park(), so
+  // the waker is not called any more.
+  using UnparkFn = void (*)(FilterTask&);
+
+  explicit FilterTask(RunFn run, ParkFn park = nullptr,
+                      UnparkFn unpark = nullptr)
+      : run_(run), park_(park), unpark_(unpark) {}
+
+ private:
+  friend class FilterExecutor;
+  friend class CooperativeScheduler;
+
+  const RunFn run_;
+  const ParkFn park_;
+  const UnparkFn unpark_;
+  // Handed to park_; puts the task back on a run queue of executor_.
+  QueueWaker waker_;
+  FilterExecutor* executor_ = nullptr;
+  // Set by detach(); the worker holding the task drops it instead of
+  // queueing it again.
+  std::atomic<bool> detaching_ = false;
+  // Set once the worker that held the task during detach() let go of it.
+  std::atomic<bool> removed_ = false;
+  // Guarded by the executor's park_mutex_. parked_: the task is off the
+  // run queues until its waker is called. woken_: the waker was called
+  // while a worker was still parking the task.
+  bool parked_ = false;
+  bool woken_ = false;
+};
+
+}  // namespace SpeechTools
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace SpeechTools {
+
+/** @brief A fixed-size, lock-free latency histogram with logarithmic buckets,
+ * in the style of HdrHistogram.
+ *
+ * Values below 16 get a bucket each; above that every power of two is split
+ * into 16 buckets, so a recorded value is known to within 1/16 (6.25%) of
+ * itself. Values up to 2^44 (about 4.9 hours in nanoseconds) are resolved;
+ * larger ones land in the last bucket.
+ *
+ * record() must only be called from one thread; the readers can run on any
+ * thread at any time and see a slightly stale but never torn count per
+ * bucket.
+ */
+class LatencyHistogram {
+ public:
+  /**
+   * @brief Adds a value (writer thread only).
+   * @param value The value, e.g. a duration in nanoseconds.
+   * @param count How many times to add it.
+   */
+  void record(uint64_t value, uint64_t count = 1) {
+    std::atomic<uint64_t>& bucket = counts_[bucketIndex(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + count,
+                 std::memory_order_relaxed);
+    if (value > max_.load(std::memory_order_relaxed)) {
+      max_.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Returns the number of recorded values (any thread).
+   * @return The total count over all buckets.
+   */
+  uint64_t count() const {
+    uint64_t total = 0;
+    for (const auto& bucket : counts_) {
+      total += bucket.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /**
+   * @brief Returns the largest recorded value (any thread).
+   * @return The maximum, or 0 if nothing was recorded.
+   */
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Estimates a percentile of the recorded values (any thread).
+   * @param percent The percentile in [0, 100], e.g. 99.9.
+   * @return The upper bound of the bucket holding the percentile, capped at
+   * max(), or 0 if nothing was recorded.
+   */
+  uint64_t percentile(double percent) const {
+    std::array<uint64_t, kBuckets> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      counts[i] = counts_[i].load(std::memory_order_relaxed);
+      total += counts[i];
+    }
+    if (total == 0) {
+      return 0;
+    }
+    double wanted = percent / 100.0 * static_cast<double>(total);
+    uint64_t rank = wanted < 1.0 ? 1 : static_cast<uint64_t>(wanted + 0.5);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        uint64_t upper = bucketUpperBound(i);
+        uint64_t largest = max();
+        return upper < largest ? upper : largest;
+      }
+    }
+    return max();
+  }
+
+ private:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+  static constexpr int kMaxExponent = 43;
+  static constexpr size_t kBuckets =
+      (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+  /**
+   * @brief Maps a value to its bucket.
+   * @param value The value.
+   * @return The bucket index.
+   */
+  static size_t bucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    int exponent = std::bit_width(value) - 1;
+    if (exponent > kMaxExponent) {
+      return kBuckets - 1;
+    }
+    int shift = exponent - kSubBucketBits;
+    uint64_t sub = (value >> shift) & (kSubBuckets - 1);
+    return (shift + 1) * kSubBuckets + sub;
+  }
+
+  /**
+   * @brief Returns the largest value that maps to a bucket.
+   * @param index The bucket index.
+   * @return The bucket's inclusive upper bound.
+   */
+  static uint64_t bucketUpperBound(size_t index) {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    int shift = static_cast<int>(index / kSubBuckets) - 1;
+    uint64_t lower = (kSubBuckets + index % kSubBuckets) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+  }
+
+  std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+  std::atomic<uint64_t> max_ = 0;
+};
+
+/**
+ * @brief Telemetry policy that records nothing.
+ *
+ * The default policy of SpeechFilter. All hooks are empty, so an
+ * uninstrumented filter does not even read the clock.
+ */
+struct FilterNoTelemetry {
+  static constexpr bool kEnabled = false;
+
+  void waiting() {}
+  void beginFrames() {}
+  void endFrames(size_t) {}
+  void blocked() {}
+  void unblocked() {}
+};
+
+/** @brief Telemetry policy recording per-frame process time, throughput, idle
+ * time and time spent blocked on a full output queue.
+ *
+ * The hooks are called only from the thread running the filter, so every
+ * counter has a single writer and is updated with relaxed loads and stores.
+ * snapshot() and processTime() can be read from any thread while the filter
+ * runs.
+ *
+ * Idle time runs from the first failed pop to the next successful one, and
+ * blocked time from the first failed push to the next successful one; each is
+ * added when it ends. Frames processed as a batch are each recorded with the
+ * batch's average time.
+ */
+class FilterTelemetry {
+ public:
+  static constexpr bool kEnabled = true;
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief A point-in-time copy of the counters.
+   */
+  struct Snapshot {
+    // Frames processed so far.
+    uint64_t frames = 0;
+    // Time since the filter was created.
+    std::chrono::nanoseconds elapsed{0};
+    // Cumulative time spent in process()/processInto()/processBatch().
+    std::chrono::nanoseconds processing{0};
+    // Cumulative time spent waiting for input.
+    std::chrono::nanoseconds idle{0};
+    // Cumulative time spent waiting for room in the output queue.
+    std::chrono::nanoseconds output_blocked{0};
+
+    /**
+     * @brief Returns the average throughput since the filter was created.
+     * @return Frames per second.
+     */
+    double framesPerSecond() const {
+      auto seconds = std::chrono::duration<double>(elapsed).count();
+      return seconds > 0.0 ? static_cast<double>(frames) / seconds : 0.0;
+    }
+
+    /**
+     * @brief Returns the share of the filter's lifetime spent idle.
+     * @return The idle ratio in [0, 1].
+     */
+    double idleRatio() const {
+      return elapsed.count() > 0 ? static_cast<double>(idle.count()) /
+                                       static_cast<double>(elapsed.count())
+                                 : 0.0;
+    }
+  };
+
+  /**
+   * @brief Records a pop that found no input (filter thread).
+   */
+  void waiting() { startPeriod(idle_); }
+
+  /**
+   * @brief Records that frames were popped and are about to be processed
+   * (filter thread).
+   */
+  void beginFrames() {
+    frames_start_ = Clock::now();
+    endPeriod(idle_, frames_start_);
+  }
+
+  /**
+   * @brief Records that the frames popped last were processed (filter
+   * thread).
+   * @param count The number of frames.
+   */
+  void endFrames(size_t count) {
+    auto took = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - frames_start_)
+                    .count();
+    process_time_.record(static_cast<uint64_t>(took) / count, count);
+    add(frames_, count);
+    add(processing_ns_, static_cast<uint64_t>(took));
+  }
+
+  /**
+   * @brief Records a push that failed because the output was full (filter
+   * thread).
+   */
+  void blocked() { startPeriod(blocked_); }
+
+  /**
+   * @brief Records that the results were pushed (filter thread).
+   */
+  void unblocked() {
+    if (blocked_.active) {
+      endPeriod(blocked_, Clock::now());
+    }
+  }
+
+  /**
+   * @brief Reads the counters (any thread).
+   * @return The current counter values.
+   */
+  Snapshot snapshot() const {
+    Snapshot s;
+    s.frames = frames_.load(std::memory_order_relaxed);
+    s.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - created_);
+    s.processing = std::chrono::nanoseconds(
+        processing_ns_.load(std::memory_order_relaxed));
+    s.idle = std::chrono::nanoseconds(
+        idle_.total_ns.load(std::memory_order_relaxed));
+    s.output_blocked = std::chrono::nanoseconds(
+        blocked_.total_ns.load(std::memory_order_relaxed));
+    return s;
+  }
+
+  /**
+   * @brief Returns the per-frame process time histogram, in nanoseconds (any
+   * thread).
+   * @return The histogram.
+   */
+  const LatencyHistogram& processTime() const { return process_time_; }
+
+ private:
+  // A kind of wait that starts and ends on the filter thread.
+  struct Period {
+    std::atomic<uint64_t> total_ns = 0;
+    // Only touched by the filter thread.
+    bool active = false;
+    Clock::time_point start;
+  };
+
+  static void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  static void startPeriod(Period& period) {
+    if (!period.active) {
+      period.active = true;
+      period.start = Clock::now();
+    }
+  }
+
+  static void endPeriod(Period& period, Clock::time_point now) {
+    if (period.active) {
+      period.active = false;
+      add(period.total_ns,
+          static_cast<uint64_t>(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  now - period.start)
+                  .count()));
+    }
+  }
+
+  const Clock::time_point created_ = Clock::now();
+  Clock::time_point frames_start_;
+  std::atomic<uint64_t> frames_ = 0;
+  std::atomic<uint64_t> processing_ns_ = 0;
+  Period idle_;
+  Period blocked_;
+  LatencyHistogram process_time_;
+};
+
+}  // namespace SpeechTools
@@ -0,0 +1,270 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "mpsc_queue.hh"
+#include "speech_filter.hh"
+
+namespace SpeechTools {
+
+/**
+ * @brief A lock-free pool of reusable frames with a return path to the thread
+ * that produces them.
+ *
+ * Frames created by a capture thread and destroyed by the last filter make the
+ * allocator hand memory across threads on every frame. A FramePool allocates
+ * its frames once. The producing thread takes them with acquire(); the handle
+ * it gets (FramePool::Frame, a std::unique_ptr) moves through the queues like
+ * any frame, and whichever thread drops it pushes the frame back onto an
+ * MPSCLockFreeQueue that the producer drains on its next acquire(). Frames
+ * keep their buffers, so a recycled std::vector does not reallocate either.
+ *
+ * When the pool is empty acquire() allocates an extra frame and counts an
+ * allocation miss; extra frames are freed when they are dropped, so only the
+ * pooled frames are ever reused. Size the pool with framesFor() so the queues
+ * can fill up without misses.
+ *
+ * acquire() must only be called from one thread at a time; frames can be
+ * dropped from any thread. A filter that produces a new frame type derives
+ * from FramePoolFilter, which gives its output its own pool and acquires from
+ * it on the filter thread, so that thread is the pool's producer. A
+ * BufferedSpeechFilter that keeps the frame type can instead modify the input
+ * frame and swap it into its output. The pool must outlive every frame it
+ * handed out, including frames still sitting in queues.
+ *
+ * @tparam T The frame type. It must be copy constructible, since frames are
+ * created as copies of a prototype.
+ */
+template <typename T>
+class FramePool {
+ public:
+  /**
+   * @brief Returns a frame to its pool when a Frame handle lets go of it.
+   */
+  class Recycler {
+   public:
+    Recycler() = default;
+    explicit Recycler(FramePool* pool) : pool_(pool) {}
+
+    void operator()(T* frame) const { pool_->release(frame); }
+
+   private:
+    FramePool* pool_ = nullptr;
+  };
+
+  // An owned frame; dropping it returns the frame to the pool.
+  using Frame = std::unique_ptr<T, Recycler>;
+
+  /**
+   * @brief A point-in-time copy of the pool counters.
+   */
+  struct Stats {
+    // Frames handed out and not yet returned.
+    size_t in_use = 0;
+    // Highest in_use seen by acquire().
+    size_t high_water = 0;
+    // acquire() calls that found no free frame and allocated one.
+    uint64_t misses = 0;
+  };
+
+  /**
+   * @brief Allocates the pool's frames up front.
+   * @param frames The number of frames, e.g. from framesFor().
+   * @param prototype The frame every pooled frame starts as a copy of, e.g. a
+   * vector already sized for one block of samples.
+   * @throws std::runtime_error If frames is zero.
+   */
+  FramePool(size_t frames, const T& prototype)
+      : prototype_(prototype), free_(frames == 0 ? 1 : frames) {
+    if (frames == 0) {
+      throw std::runtime_error("FramePool needs at least one frame.");
+    }
+    frames_ = std::make_unique<Storage[]>(frames);
+    frame_count_ = frames;
+    for (size_t i = 0; i < frames; ++i) {
+      T* frame = std::construct_at(frames_[i].ptr(), prototype_);
+      free_.try_push(frame);
+    }
+  }
+
+  /**
+   * @brief Destroys every frame. All frames must have been returned.
+   */
+  ~FramePool() {
+    for (size_t i = 0; i < frame_count_; ++i) {
+      std::destroy_at(std::launder(frames_[i].ptr()));
+    }
+  }
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  /**
+   * @brief Returns the number of frames a pipeline needs so it never misses:
+   * every queue full, plus one frame held on each side of each queue.
+   * @param queues The queues the pooled frames travel through.
+   * @return The recommended pool size.
+   */
+  template <typename... Queues>
+  static size_t framesFor(const Queues&... queues) {
+    return (queues.capacity() + ... + 0) + sizeof...(Queues) + 1;
+  }
+
+  /**
+   * @brief Takes a free frame, allocating one if the pool is empty (producer
+   * thread only).
+   * @return The frame, holding whatever its previous user left in it.
+   */
+  Frame acquire() {
+    T* frame = nullptr;
+    if (!free_.try_pop(frame)) {
+      frame = new T(prototype_);
+      misses_.store(misses_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+    size_t in_use = in_use_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (in_use > high_water_.load(std::memory_order_relaxed)) {
+      high_water_.store(in_use, std::memory_order_relaxed);
+    }
+    return Frame(frame, Recycler(this));
+  }
+
+  /**
+   * @brief Reads the counters (any thread).
+   * @return The current counter values.
+   */
+  Stats stats() const {
+    Stats s;
+    s.in_use = in_use_.load(std::memory_order_relaxed);
+    s.high_water = high_water_.load(std::memory_order_relaxed);
+    s.misses = misses_.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  /**
+   * @brief Returns the number of frames allocated up front.
+   * @return The pool size given at construction.
+   */
+  size_t capacity() const { return frame_count_; }
+
+ private:
+  // Uninitialised storage for one pooled frame.
+  struct Storage {
+    alignas(T) std::byte bytes[sizeof(T)];
+
+    T* ptr() { return reinterpret_cast<T*>(bytes); }
+  };
+
+  /**
+   * @brief Puts a frame back for the producer to reuse (any thread).
+   * @param frame A frame handed out by acquire().
+   */
+  void release(T* frame) {
+    in_use_.fetch_sub(1, std::memory_order_relaxed);
+    if (!owns(frame)) {
+      delete frame;
+      return;
+    }
+    // The return queue holds every pooled frame, so this cannot fail.
+    free_.try_push(frame);
+  }
+
+  /**
+   * @brief Checks whether a frame lives in the up-front allocation.
+   * @param frame The frame.
+   * @return true for pooled frames, false for frames allocated on a miss.
+   */
+  bool owns(const T* frame) const {
+    auto address = reinterpret_cast<uintptr_t>(frame);
+    auto begin = reinterpret_cast<uintptr_t>(frames_.get());
+    return address >= begin && address < begin + frame_count_ * sizeof(Storage);
+  }
+
+  const T prototype_;
+  std::unique_ptr<Storage[]> frames_;
+  size_t frame_count_ = 0;
+  // Frames waiting to be reused; any thread returns, the producer takes.
+  MPSCLockFreeQueue<T*> free_;
+
+  std::atomic<size_t> in_use_ = 0;
+  // Written by the producer only.
+  std::atomic<size_t> high_water_ = 0;
+  std::atomic<uint64_t> misses_ = 0;
+};
+
+/** @brief Base class for filters whose output frames come from a FramePool.
+ *
+ * The filter acquires a frame from the pool whenever its output buffer was
+ * pushed on, and deriving filters write each result into that frame's payload
+ * in processPooled(). Downstream stages drop the frames as usual, which
+ * returns them to the pool, so a pipeline whose pool is sized with framesFor()
+ * allocates nothing per frame. Input frames may come from another pool; the
+ * filter drops each one once the next replaces it. PeekQueue inputs are read
+ * in place. Everything else is as in BufferedSpeechFilter.
+ *
+ * The pool must only be acquired from by this filter, and outlive it.
+ * @tparam T The payload of the pooled output frames.
+ */
+template <class InType, class T,
+          template <typename> class QueueType = SPSCParkingQueue,
+          class Telemetry = FilterNoTelemetry,
+          template <typename> class InQueueType = QueueType>
+class FramePoolFilter
+    : public BufferedSpeechFilter<InType, typename FramePool<T>::Frame,
+                                  QueueType, Telemetry, InQueueType> {
+  using Base = BufferedSpeechFilter<InType, typename FramePool<T>::Frame,
+                                    QueueType, Telemetry, InQueueType>;
+
+ public:
+  using Frame = typename FramePool<T>::Frame;
+
+  /**
+   * @brief Creates the filter; see the BufferedSpeechFilter constructors.
+   * @param pool The pool output frames are acquired from.
+   * @param in The queue to read frames from.
+   * @param out The queue to write pooled frames to.
+   * @param args The remaining BufferedSpeechFilter constructor arguments.
+   */
+  template <typename... Args>
+  FramePoolFilter(FramePool<T>& pool, InQueueType<InType>& in,
+                  QueueType<Frame>& out, Args&&... args)
+      : Base(in, out, std::forward<Args>(args)...), pool_(pool) {}
+
+ protected:
+  /**
+   * @brief Processes one frame into a pooled frame.
+   * @param input_data The frame to process.
+   * @param output_data The pooled frame's payload, holding whatever its
+   * previous user left in it.
+   */
+  virtual void processPooled(const InType& input_data, T& output_data) = 0;
+
+  void processInto(InType& input_data, Frame& output_data) override {
+    processPooled(input_data, acquired(output_data));
+  }
+
+  void processPeeked(const InType& input_data, Frame& output_data) override {
+    processPooled(input_data, acquired(output_data));
+  }
+
+ private:
+  /**
+   * @brief Gives an output buffer a pooled frame unless it still holds one.
+   * @param output_data The output buffer; empty once its frame was pushed on.
+   * @return The frame's payload.
+   */
+  T& acquired(Frame& output_data) {
+    if (!output_data) {
+      output_data = pool_.acquire();
+    }
+    return *output_data;
+  }
+
+  FramePool<T>& pool_;
+};
+
+}  // namespace SpeechTools
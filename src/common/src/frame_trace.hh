@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+namespace SpeechTools {
+
+// Most filter hops recorded per frame; later hops are not recorded.
+inline constexpr size_t kMaxTraceHops = 8;
+
+// Highest stage handed out to filters; the stage above it is reserved for
+// the sink (FrameTraceWriter::kSinkStage).
+inline constexpr uint16_t kMaxFilterTraceStage = UINT16_MAX - 1;
+
+/**
+ * @brief Returns the monotonic clock used for frame traces.
+ * @return Nanoseconds since an unspecified epoch (steady_clock).
+ */
+inline int64_t traceNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief One filter's stamps on a frame: when it popped the frame and when it
+ * finished processing it. The time since the previous hop (or capture) is the
+ * time the frame spent queued.
+ */
+struct TraceHop {
+  uint16_t stage = 0;
+  int64_t dequeued_ns = 0;
+  int64_t processed_ns = 0;
+};
+
+/**
+ * @brief The timing history of one frame, from capture through every filter.
+ *
+ * Fixed size, so stamping a frame never allocates.
+ */
+struct FrameTrace {
+  uint64_t sequence = 0;
+  int64_t capture_ns = 0;
+  uint8_t hop_count = 0;
+  std::array<TraceHop, kMaxTraceHops> hops{};
+
+  /**
+   * @brief Starts the trace of a newly captured frame.
+   * @param sequence The frame's sequence number.
+   * @return A trace stamped with the current time and no hops.
+   */
+  static FrameTrace start(uint64_t sequence) {
+    FrameTrace trace;
+    trace.sequence = sequence;
+    trace.capture_ns = traceNow();
+    return trace;
+  }
+
+  /**
+   * @brief Appends a filter's stamps, unless kMaxTraceHops were recorded.
+   * @param stage The filter's trace stage.
+   * @param dequeued_ns When the filter popped the frame.
+   * @param processed_ns When the filter finished processing it.
+   */
+  void addHop(uint16_t stage, int64_t dequeued_ns, int64_t processed_ns) {
+    if (hop_count < kMaxTraceHops) {
+      hops[hop_count++] = {stage, dequeued_ns, processed_ns};
+    }
+  }
+};
+
+/**
+ * @brief A frame envelope: a payload together with its trace.
+ *
+ * A SpeechFilter whose input and output types are both Traced stamps every
+ * frame it processes and carries the trace over to its output; the filter
+ * itself only works on payload.
+ * @tparam T The payload type.
+ */
+template <typename T>
+struct Traced {
+  using PayloadType = T;
+
+  T payload{};
+  FrameTrace trace;
+};
+
+namespace detail {
+
+/**
+ * @brief Hands out the next stage of a counter, saturating at
+ * kMaxFilterTraceStage so the counter never reaches the sink stage or wraps
+ * around to stages already in use.
+ * @param next The counter.
+ * @return The stage; kMaxFilterTraceStage for every call once the stages
+ * below it are used up.
+ */
+inline uint16_t nextTraceStage(std::atomic<uint16_t>& next) {
+  uint16_t stage = next.load(std::memory_order_relaxed);
+  while (stage < kMaxFilterTraceStage &&
+         !next.compare_exchange_weak(stage, stage + 1,
+                                     std::memory_order_relaxed)) {
+  }
+  return stage;
+}
+
+// Hands out a distinct default trace stage to every SpeechFilter, until
+// kMaxFilterTraceStage filters were created.
+inline uint16_t nextTraceStage() {
+  static std::atomic<uint16_t> next = 0;
+  return nextTraceStage(next);
+}
+
+}  // namespace detail
+
+// Concept for frame envelopes that SpeechFilter stamps, such as Traced<T>.
+template <typename Frame>
+concept TracedFrame = requires(Frame& frame) {
+  { frame.trace } -> std::same_as<FrameTrace&>;
+};
+
+// Output format of a FrameTraceWriter.
+enum class TraceFormat {
+  kChromeJson,  // Trace-event JSON for chrome://tracing or Perfetto.
+  kBinary,      // Compact binary records, see FrameTraceWriter.
+};
+
+/** @brief Writes the traces of frames leaving a pipeline to a file, for
+ * finding latency regressions offline.
+ *
+ * The sink calls record() with each frame's trace after popping it from the
+ * last queue. In Chrome JSON every hop becomes a "queued" and a "process"
+ * event on the track of the filter's stage, and the time from the last filter
+ * to the sink a "queued" event on the sink track; all events of a frame carry
+ * its sequence number. The binary format starts with the magic "SPTR" and a
+ * uint32 version, followed by records in host byte order: 'F', sequence
+ * (u64), capture_ns, sink_ns (i64), hop count (u8) and per hop stage (u16),
+ * dequeued_ns and processed_ns (i64); or 'N', stage (u16), name length (u16)
+ * and the name bytes.
+ *
+ * Not thread-safe; use one writer per sink thread.
+ */
+class FrameTraceWriter {
+ public:
+  // Bumped whenever the binary layout changes.
+  static constexpr uint32_t kBinaryVersion = 1;
+  // Stage the sink's events are reported under; never used by a filter.
+  static constexpr uint16_t kSinkStage = kMaxFilterTraceStage + 1;
+
+  /**
+   * @brief Creates or truncates the trace file.
+   * @param path The file to write.
+   * @param format The output format.
+   * @throws std::runtime_error If the file cannot be opened.
+   */
+  FrameTraceWriter(const std::string& path, TraceFormat format)
+      : out_(path, std::ios::binary | std::ios::trunc), format_(format) {
+    if (!out_) {
+      throw std::runtime_error("Cannot open trace file " + path + ".");
+    }
+    if (format_ == TraceFormat::kChromeJson) {
+      out_ << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+      nameStage(kSinkStage, "sink");
+    } else {
+      out_.write("SPTR", 4);
+      writeValue(kBinaryVersion);
+    }
+  }
+
+  /**
+   * @brief Finishes the file.
+   */
+  ~FrameTraceWriter() { close(); }
+
+  FrameTraceWriter(const FrameTraceWriter&) = delete;
+  FrameTraceWriter& operator=(const FrameTraceWriter&) = delete;
+
+  /**
+   * @brief Names a trace stage, e.g. after the filter that uses it.
+   * @param stage The stage, see SpeechFilter::traceStage().
+   * @param name The name shown for it. The binary format keeps only its first
+   * UINT16_MAX bytes.
+   */
+  void nameStage(uint16_t stage, const std::string& name) {
+    if (format_ == TraceFormat::kChromeJson) {
+      beginEvent();
+      out_ << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":"
+           << stage << ",\"args\":{\"name\":\"";
+      writeEscaped(name);
+      out_ << "\"}}";
+    } else {
+      auto length = static_cast<uint16_t>(
+          std::min<size_t>(name.size(), UINT16_MAX));
+      out_.put('N');
+      writeValue(stage);
+      writeValue(length);
+      out_.write(name.data(), length);
+    }
+  }
+
+  /**
+   * @brief Records a frame that reached the sink.
+   * @param trace The frame's trace.
+   * @param sink_ns When the sink popped the frame; defaults to now.
+   */
+  void record(const FrameTrace& trace, int64_t sink_ns = traceNow()) {
+    if (format_ == TraceFormat::kBinary) {
+      out_.put('F');
+      writeValue(trace.sequence);
+      writeValue(trace.capture_ns);
+      writeValue(sink_ns);
+      writeValue(trace.hop_count);
+      for (size_t i = 0; i < trace.hop_count; ++i) {
+        writeValue(trace.hops[i].stage);
+        writeValue(trace.hops[i].dequeued_ns);
+        writeValue(trace.hops[i].processed_ns);
+      }
+      return;
+    }
+    int64_t ready_ns = trace.capture_ns;
+    for (size_t i = 0; i < trace.hop_count; ++i) {
+      const TraceHop& hop = trace.hops[i];
+      writeSpan("queued", hop.stage, ready_ns, hop.dequeued_ns,
+                trace.sequence);
+      writeSpan("process", hop.stage, hop.dequeued_ns, hop.processed_ns,
+                trace.sequence);
+      ready_ns = hop.processed_ns;
+    }
+    writeSpan("queued", kSinkStage, ready_ns, sink_ns, trace.sequence);
+  }
+
+  /**
+   * @brief Completes and closes the file; later calls do nothing.
+   */
+  void close() {
+    if (!out_.is_open()) {
+      return;
+    }
+    if (format_ == TraceFormat::kChromeJson) {
+      out_ << "]}\n";
+    }
+    out_.close();
+  }
+
+ private:
+  void beginEvent() {
+    if (!first_event_) {
+      out_ << ",\n";
+    }
+    first_event_ = false;
+  }
+
+  // Writes a complete ("X") event; Chrome timestamps are in microseconds.
+  void writeSpan(const char* name, uint16_t stage, int64_t begin_ns,
+                 int64_t end_ns, uint64_t sequence) {
+    beginEvent();
+    out_ << "{\"ph\":\"X\",\"name\":\"" << name << "\",\"pid\":0,\"tid\":"
+         << stage << ",\"ts\":" << static_cast<double>(begin_ns) / 1e3
+         << ",\"dur\":" << static_cast<double>(end_ns - begin_ns) / 1e3
+         << ",\"args\":{\"seq\":" << sequence << "}}";
+  }
+
+  // Writes text as the contents of a JSON string literal.
+  void writeEscaped(const std::string& text) {
+    constexpr char kHex[] = "0123456789abcdef";
+    for (char c : text) {
+      auto byte = static_cast<unsigned char>(c);
+      if (c == '"' || c == '\\') {
+        out_ << '\\' << c;
+      } else if (byte < 0x20) {
+        out_ << "\\u00" << kHex[byte >> 4] << kHex[byte & 0xf];
+      } else {
+        out_ << c;
+      }
+    }
+  }
+
+  template <typename Value>
+  void writeValue(Value value) {
+    out_.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  std::ofstream out_;
+  const TraceFormat format_;
+  bool first_event_ = true;
+};
+
+}  // namespace SpeechTools
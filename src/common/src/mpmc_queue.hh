@@ -0,0 +1,21 @@
+#pragma once
+#include "slot_sequence_queue.hh"
+
+/**
+ * @brief A bounded Multi-Producer, Multi-Consumer (MPMC) lock-free queue.
+ *
+ * Lets several worker threads pull from one queue, e.g. to spread a heavy
+ * filter over cores by running one SpeechFilter instance per worker on shared
+ * input and output queues. Producers and consumers each claim slots with a
+ * compare-and-swap, so threads on the same side never wait on each other's
+ * element copies. See SlotSequenceQueue.
+ *
+ * Elements are popped in the order their slots were claimed. A pop can report
+ * empty while a producer that claimed the oldest slot is still writing it,
+ * and a push can report full while a consumer is still reading the slot.
+ *
+ * @tparam T The type of elements to store in the queue. T must be movable or
+ * copyable.
+ */
+template <typename T>
+using MPMCLockFreeQueue = SlotSequenceQueue<T, QueueConsumers::kMulti>;
@@ -0,0 +1,20 @@
+#pragma once
+#include "slot_sequence_queue.hh"
+
+/**
+ * @brief A bounded Multi-Producer, Single-Consumer (MPSC) lock-free queue.
+ *
+ * Lets several producer threads (e.g. capture sources) feed one consumer, such
+ * as a SpeechFilter, without a merger thread per source. Producers claim a
+ * slot with a compare-and-swap and never wait on each other; the consumer
+ * needs no read-modify-write at all. See SlotSequenceQueue.
+ *
+ * Elements from one producer are popped in the order that producer pushed
+ * them. A pop can report empty while a producer that claimed the oldest slot
+ * is still writing it, even if later slots are already published.
+ *
+ * @tparam T The type of elements to store in the queue. T must be movable or
+ * copyable.
+ */
+template <typename T>
+using MPSCLockFreeQueue = SlotSequenceQueue<T, QueueConsumers::kSingle>;
@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Instrumentation policy that records nothing.
+ *
+ * The default policy of the queues. All hooks are empty and the queues skip
+ * computing their arguments, so an uninstrumented queue pays nothing.
+ */
+struct SPSCNoStats {
+  static constexpr bool kEnabled = false;
+
+  void push_failed() {}
+  void pushed(size_t) {}
+  void pop_failed() {}
+  void popped() {}
+};
+
+/**
+ * @brief Instrumentation policy recording full/empty failures, peak occupancy
+ * and the time each side spent unable to make progress.
+ *
+ * Producer-side hooks are only called from the producer thread and
+ * consumer-side hooks only from the consumer thread, so every counter has a
+ * single writer and is updated with relaxed loads and stores. snapshot() can
+ * be called from any thread at any time.
+ *
+ * A stall starts at the first failed push (pop) and ends at the next
+ * successful one; its duration is added to the cumulative stall time when it
+ * ends, so a stall still in progress is not yet included in a snapshot.
+ */
+class SPSCQueueStats {
+ public:
+  static constexpr bool kEnabled = true;
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief A point-in-time copy of the counters.
+   */
+  struct Snapshot {
+    // Push attempts that failed because the queue was full.
+    uint64_t push_full = 0;
+    // Pop attempts that failed because the queue was empty.
+    uint64_t pop_empty = 0;
+    // Highest number of elements observed in the queue after a push.
+    size_t peak_occupancy = 0;
+    // Cumulative time the producer spent unable to push.
+    std::chrono::nanoseconds producer_stalled{0};
+    // Cumulative time the consumer spent unable to pop.
+    std::chrono::nanoseconds consumer_stalled{0};
+  };
+
+  /**
+   * @brief Records a push that failed because the queue was full (producer).
+   */
+  void push_failed() {
+    bump(producer_.failures);
+    if (!producer_.stalled) {
+      producer_.stalled = true;
+      producer_.stall_start = Clock::now();
+    }
+  }
+
+  /**
+   * @brief Records a successful push (producer).
+   * @param occupancy The number of elements in the queue after the push.
+   */
+  void pushed(size_t occupancy) {
+    end_stall(producer_);
+    if (occupancy > peak_occupancy_.load(std::memory_order_relaxed)) {
+      peak_occupancy_.store(occupancy, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Records a pop that failed because the queue was empty (consumer).
+   */
+  void pop_failed() {
+    bump(consumer_.failures);
+    if (!consumer_.stalled) {
+      consumer_.stalled = true;
+      consumer_.stall_start = Clock::now();
+    }
+  }
+
+  /**
+   * @brief Records a successful pop (consumer).
+   */
+  void popped() { end_stall(consumer_); }
+
+  /**
+   * @brief Reads the counters (any thread).
+   * @return The current counter values.
+   */
+  Snapshot snapshot() const {
+    Snapshot s;
+    s.push_full = producer_.failures.load(std::memory_order_relaxed);
+    s.pop_empty = consumer_.failures.load(std::memory_order_relaxed);
+    s.peak_occupancy = peak_occupancy_.load(std::memory_order_relaxed);
+    s.producer_stalled = std::chrono::nanoseconds(
+        producer_.stalled_ns.load(std::memory_order_relaxed));
+    s.consumer_stalled = std::chrono::nanoseconds(
+        consumer_.stalled_ns.load(std::memory_order_relaxed));
+    return s;
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  // Counters written by one side of the queue.
+  struct alignas(kCacheLineSize) Side {
+    std::atomic<uint64_t> failures = 0;
+    std::atomic<int64_t> stalled_ns = 0;
+    // Only touched by the owning side.
+    bool stalled = false;
+    Clock::time_point stall_start;
+  };
+
+  /**
+   * @brief Increments a single-writer counter.
+   * @param counter The counter to increment.
+   */
+  static void bump(std::atomic<uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Ends a side's stall, if any, and accumulates its duration.
+   * @param side The side that made progress.
+   */
+  static void end_stall(Side& side) {
+    if (side.stalled) {
+      side.stalled = false;
+      auto stalled = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - side.stall_start);
+      side.stalled_ns.store(
+          side.stalled_ns.load(std::memory_order_relaxed) + stalled.count(),
+          std::memory_order_relaxed);
+    }
+  }
+
+  Side producer_;
+  Side consumer_;
+  // Written by the producer only.
+  alignas(kCacheLineSize) std::atomic<size_t> peak_occupancy_ = 0;
+};
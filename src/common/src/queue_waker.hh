@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+ * @brief A callback that wakes the consumer or producer side of a queue when
+ * that side is not a thread of its own, such as a filter on a FilterExecutor.
+ *
+ * Registered with park_consumer() or park_producer() of a parking queue (see
+ * SPSCParkingQueue). The queue calls wake(context) once, from the thread whose
+ * push, pop or wake call ends the wait.
+ */
+struct QueueWaker {
+  void (*wake)(void* context) = nullptr;
+  void* context = nullptr;
+};
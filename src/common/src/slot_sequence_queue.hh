@@ -0,0 +1,249 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Selects whether a SlotSequenceQueue can be popped from one thread or
+ * from many.
+ */
+enum class QueueConsumers {
+  // One consumer thread; it advances head_ with a plain store.
+  kSingle,
+  // Any number of consumer threads; they claim slots with a compare-and-swap.
+  kMulti,
+};
+
+/**
+ * @brief The bounded lock-free queue behind MPSCLockFreeQueue and
+ * MPMCLockFreeQueue (Vyukov's slot sequence design).
+ *
+ * Each slot carries a sequence number that tells producers whether it is free
+ * and consumers whether it has been published. Producers claim a slot by
+ * advancing tail_ with a compare-and-swap and never wait on each other's
+ * element copies; consumers do the same on head_, unless there is only one.
+ *
+ * The capacity is rounded up to a power of two so slots are found by masking,
+ * and to at least two: with a single slot, the sequence a push leaves behind
+ * equals the next push's position, so a full queue would look empty to
+ * producers and overwrite its element.
+ *
+ * @tparam T The type of elements to store in the queue. T must be movable or
+ * copyable.
+ * @tparam Consumers Whether one or many threads pop, see QueueConsumers.
+ */
+template <typename T, QueueConsumers Consumers>
+class SlotSequenceQueue {
+  static constexpr bool kMultiConsumer = Consumers == QueueConsumers::kMulti;
+  static constexpr const char* kName =
+      kMultiConsumer ? "MPMCLockFreeQueue" : "MPSCLockFreeQueue";
+
+ public:
+  using ValueType = T;
+
+  /**
+   * @brief Constructs a queue with a specified capacity.
+   * @param capacity The maximum number of elements the queue can hold, rounded
+   * up to a power of two of at least two.
+   * @throws std::runtime_error If capacity is zero or cannot be rounded up.
+   */
+  explicit SlotSequenceQueue(size_t capacity) {
+    if (capacity == 0) {
+      throw std::runtime_error(std::string(kName) +
+                               " capacity cannot be zero.");
+    }
+    if (capacity > (SIZE_MAX >> 2)) {
+      throw std::runtime_error(std::string(kName) + " capacity too large.");
+    }
+    capacity_ = std::max<size_t>(2, std::bit_ceil(capacity));
+    mask_ = capacity_ - 1;
+    slots_ = std::make_unique<Slot[]>(capacity_);
+    for (size_t i = 0; i < capacity_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Destroys the queue and any elements still stored in it.
+   */
+  ~SlotSequenceQueue() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      size_t pos = head_.load(std::memory_order_relaxed);
+      for (;; ++pos) {
+        Slot& slot = slots_[pos & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+          break;
+        }
+        std::destroy_at(slot.element());
+      }
+    }
+  }
+
+  SlotSequenceQueue(const SlotSequenceQueue&) = delete;
+  SlotSequenceQueue& operator=(const SlotSequenceQueue&) = delete;
+  SlotSequenceQueue(SlotSequenceQueue&&) = delete;
+  SlotSequenceQueue& operator=(SlotSequenceQueue&&) = delete;
+
+  /**
+   * @brief Attempts to push an element into the queue (non-blocking, copy).
+   * Safe to call from any number of threads.
+   * @param value The element to copy into the queue.
+   * @return true if the element was successfully pushed, false if the queue is
+   * full.
+   */
+  bool try_push(const T& value) { return try_emplace(value); }
+
+  /**
+   * @brief Attempts to push an element into the queue (non-blocking, move).
+   * Safe to call from any number of threads.
+   * @param value The element to move into the queue. Left untouched if the
+   * queue is full.
+   * @return true if the element was successfully pushed, false if the queue is
+   * full.
+   */
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  /**
+   * @brief Attempts to construct an element in place at the back of the queue
+   * (non-blocking). Safe to call from any number of threads.
+   * @param args The arguments forwarded to T's constructor. They are left
+   * untouched if the queue is full.
+   * @return true if the element was successfully pushed, false if the queue is
+   * full.
+   */
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &slots_[pos & mask_];
+      size_t seq = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        // The slot is free for this lap: try to claim it.
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // Queue is full: the slot is a lap behind
+      } else {
+        // Another producer claimed this position first.
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    std::construct_at(slot->storage_ptr(), std::forward<Args>(args)...);
+    // Release so the consumer sees the element once it sees the sequence.
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Attempts to pop an element from the queue (non-blocking). With
+   * QueueConsumers::kSingle it must only be called from the single consumer
+   * thread; with kMulti it is safe to call from any number of threads.
+   * @param value A reference to store the popped element.
+   * @return true if an element was successfully popped, false if the queue is
+   * empty or its oldest element is still being written.
+   */
+  bool try_pop(T& value) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &slots_[pos & mask_];
+      size_t seq = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+      if (diff < 0) {
+        return false;  // Queue is empty: the slot is not published yet
+      }
+      if constexpr (kMultiConsumer) {
+        if (diff == 0) {
+          // The slot is published for this lap: try to claim it.
+          if (head_.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed)) {
+            break;
+          }
+        } else {
+          // Another consumer claimed this position first.
+          pos = head_.load(std::memory_order_relaxed);
+        }
+      } else {
+        break;
+      }
+    }
+
+    T* front = slot->element();
+    value = std::move(*front);
+    std::destroy_at(front);
+    // Hand the slot to the producers for the next lap.
+    slot->sequence.store(pos + capacity_, std::memory_order_release);
+    if constexpr (!kMultiConsumer) {
+      // The only consumer owns head_ and needs no read-modify-write.
+      head_.store(pos + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Returns the approximate number of elements currently in the queue.
+   * @return The number of claimed slots not yet popped, clamped to capacity().
+   */
+  size_t size() const {
+    size_t current_head = head_.load(std::memory_order_acquire);
+    size_t current_tail = tail_.load(std::memory_order_acquire);
+    return current_tail > current_head
+               ? std::min(current_tail - current_head, capacity_)
+               : 0;
+  }
+
+  /**
+   * @brief Checks if the queue is empty.
+   * @return true if the queue contains no elements, false otherwise.
+   */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Checks if the queue is full.
+   * @return true if the queue has reached its maximum capacity, false
+   * otherwise.
+   */
+  bool full() const { return size() == capacity_; }
+
+  /**
+   * @brief Returns the maximum number of elements the queue can hold.
+   * @return The capacity, after rounding.
+   */
+  size_t capacity() const { return capacity_; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  // One element slot. sequence == position: free for the producer writing
+  // that position; sequence == position + 1: published for the consumers.
+  struct Slot {
+    std::atomic<size_t> sequence;
+    alignas(T) std::byte storage[sizeof(T)];
+
+    T* storage_ptr() { return reinterpret_cast<T*>(storage); }
+    T* element() { return std::launder(storage_ptr()); }
+  };
+
+  // Read-only after construction.
+  size_t capacity_ = 0;
+  size_t mask_ = 0;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Read position, owned by the consumer or shared by the consumers.
+  alignas(kCacheLineSize) std::atomic<size_t> head_ = 0;
+  // Write position shared by the producers.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_ = 0;
+};
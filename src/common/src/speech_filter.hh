@@ -1,9 +1,26 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <stdexcept>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "cooperative_scheduler.hh"
+#include "end_of_stream.hh"
+#include "filter_executor.hh"
+#include "filter_telemetry.hh"
+#include "frame_trace.hh"
+#include "queue_waker.hh"
 #include "spsc_queue.hh"
+#include "thread_options.hh"
+#include "wait_strategy.hh"
 
 namespace SpeechTools {
 
@@ -14,62 +31,1145 @@ concept QueueWithValueType = requires {
   requires std::same_as<typename Queue::ValueType, ExpectedType>;
 };
 
-/** @brief Base class for all filters. Deriving filters implement the process()
- * method, which gets called in the base class's processLoop().
+// Concept for queues whose consumer and producer can park until woken, such as
+// SPSCParkingQueue.
+template <typename Queue>
+concept ParkableQueue = requires(Queue& q, bool (*cancelled)()) {
+  q.wait_for_data(cancelled);
+  q.wait_for_space(cancelled);
+  q.wake_consumer();
+  q.wake_producer();
+};
+
+// Concept for queues whose consumer and producer can also park without a
+// thread, handing over a QueueWaker, such as SPSCParkingQueue.
+template <typename Queue>
+concept WakerQueue = requires(Queue& q, const QueueWaker& waker) {
+  { q.park_consumer(waker) } -> std::same_as<bool>;
+  { q.park_producer(waker) } -> std::same_as<bool>;
+  q.cancel_consumer_park();
+  q.cancel_producer_park();
+};
+
+// Concept for queues that move several elements per call, such as
+// SPSCLockFreeQueue.
+template <typename Queue>
+concept BatchQueue = requires(Queue& q, typename Queue::ValueType* values,
+                              size_t count) {
+  { q.try_pop_n(values, count) } -> std::same_as<size_t>;
+  {
+    q.try_push_n(std::make_move_iterator(values), count)
+  } -> std::same_as<size_t>;
+};
+
+// Concept for queues whose consumer can take elements out by value; all but
+// views into the queue's storage, such as AudioWindowReader.
+template <typename Queue>
+concept PopQueue = requires(Queue& q, typename Queue::ValueType& value) {
+  { q.try_pop(value) } -> std::same_as<bool>;
+};
+
+// Concept for queues whose consumer reads the oldest element in place and
+// then releases it, such as BroadcastReader.
+template <typename Queue>
+concept PeekQueue = requires(Queue& q) {
+  { q.peek() } -> std::convertible_to<const typename Queue::ValueType*>;
+  q.release();
+};
+
+// Concept for queues whose producer writes the next element in place and then
+// publishes it, such as SPSCLockFreeQueue.
+template <typename Queue>
+concept ClaimQueue = requires(Queue& q) {
+  { q.claim_write() } -> std::same_as<typename Queue::ValueType*>;
+  q.commit_write();
+};
+
+/** @brief Base class for all filters. Deriving filters implement
+ * processInto(), which writes each frame into an output buffer and gets
+ * called in the base class's processLoop(). Filters that simply return each
+ * result derive from SpeechFilter and implement process() instead.
+ *
+ * When the output queue is a ClaimQueue, such as SPSCLockFreeQueue, that
+ * buffer is the queue's next slot, claimed with claim_write() and published
+ * with commit_write(). A consumer that reads the queue with peek_read()/
+ * release_read() leaves each frame in its slot, so the filter overwrites a
+ * frame that already owns its storage and a filter that writes its result
+ * into output_data allocates nothing per frame. Other queues, and consumers
+ * that pop, hand the filter a moved-from buffer instead, which only a filter
+ * that swaps its input into output_data gets by without allocating.
+ *
+ * The WaitStrategy passed at construction decides how the filter thread waits
+ * on an empty input or full output queue: latency-critical filters can spin
+ * and background ones park. Parking needs a ParkableQueue, such as the
+ * default SPSCParkingQueue, so an idle WaitStrategy::kPark filter uses no CPU.
+ * Other queues, e.g. SPSCLockFreeQueue, skip the wake-up fence on every push
+ * and pop, but WaitStrategy::kPark can only sleep briefly between retries on
+ * them.
+ *
+ * A filter either runs on its own thread or, when constructed with a
+ * FilterExecutor, is attached to that shared worker pool. Pooled filters never
+ * block a worker: a result that does not fit in the output queue is kept and
+ * pushed on a later turn. A worker may run a pooled filter as soon as it is
+ * attached, so pooled filters are created stopped: start() must be called once
+ * the deriving filter is fully constructed, and stop() or drain() before it is
+ * destroyed. ScopedFilter does both, so a pooled filter is normally created as
+ * ScopedFilter<MyFilter>. A filter constructed with a CooperativeScheduler runs
+ * the same turns, but only when the scheduler's owner drives it, on the
+ * owner's thread.
  *
+ * With a max_batch above one, the filter takes up to that many frames per
+ * wake-up and hands them to processBatch() together, so cheap filters pay the
+ * queue atomics and virtual call once per batch and SIMD-heavy filters can
+ * amortise setup when catching up after a stall. Batches move through
+ * try_pop_n()/try_push_n() when the queues are a BatchQueue.
+ *
+ * A filter with its own thread can pin it to cores, give it a real-time
+ * policy, name it and lock memory through ThreadOptions. They are applied
+ * before the thread processes anything; threadStatus() reports which of them
+ * the OS refused.
+ *
+ * stop() halts a filter immediately and drops whatever it still holds. For
+ * jobs that must not be truncated, drain() instead processes everything
+ * queued, lets the filter emit its remaining output through flush(), sends an
+ * end-of-stream marker downstream when OutType has one (see EndOfStream) and
+ * then stops. A filter that pops such a marker drains itself the same way,
+ * so draining the first filter of a pipeline drains the whole pipeline.
+ *
+ * When InType and OutType are both frame envelopes (TracedFrame, e.g.
+ * Traced<T>), the filter stamps each frame with the time it popped it and the
+ * time it finished processing it, under its traceStage(), and carries the
+ * trace over to the output frame. Filters only need to handle the payload.
+ *
+ * @tparam QueueType The queue template the filter writes to, and by default
+ * reads from.
+ * @tparam Telemetry The instrumentation policy, FilterNoTelemetry (no cost)
+ * or FilterTelemetry; see telemetry().
+ * A PeekQueue input, such as a BroadcastReader taking one of several fan-out
+ * branches of an SPMCBroadcastRing, is read in place: each frame is handed to
+ * processPeeked() while it is still in the queue, and a SpeechFilter's
+ * process() reads it there without a copy. Filters with a max_batch above one
+ * still copy their batches out of such a queue. Its frames must be copy
+ * assignable, as SPMCBroadcastRing's are; other frames fail to compile.
+ *
+ * @tparam InQueueType The queue template the filter reads from, when it
+ * differs from QueueType, e.g. BroadcastReader.
  */
 template <class InType, class OutType,
-          template <typename> class QueueType = SPSCLockFreeQueue>
-class SpeechFilter {
+          template <typename> class QueueType = SPSCParkingQueue,
+          class Telemetry = FilterNoTelemetry,
+          template <typename> class InQueueType = QueueType>
+class BufferedSpeechFilter : private FilterTask {
   using ThreadType = std::thread;
 
  public:
-  SpeechFilter(QueueType<InType>& in, QueueType<OutType>& out)
-      : inQueue_(in), outQueue_(out) {
+  /**
+   * @brief Starts a filter on its own thread.
+   * @param in The queue to read frames from.
+   * @param out The queue to write processed frames to.
+   * @param wait How the thread waits on an empty or full queue.
+   * @param max_batch The most frames processed per processBatch() call; 1
+   * processes frames one at a time through processInto().
+   * @param thread_options OS settings for the filter thread, applied every
+   * time it is started.
+   * @throws std::runtime_error If max_batch is zero, or above 1 for an input
+   * queue that only views frames in place (not a PopQueue).
+   */
+  BufferedSpeechFilter(InQueueType<InType>& in, QueueType<OutType>& out,
+                       WaitStrategy wait = WaitStrategy::kYield,
+                       size_t max_batch = 1, ThreadOptions thread_options = {})
+      : FilterTask(&BufferedSpeechFilter::runTask,
+                   &BufferedSpeechFilter::parkTask,
+                   &BufferedSpeechFilter::unparkTask),
+        wait_(wait),
+        max_batch_(checkBatch(max_batch)),
+        inQueue_(in),
+        outQueue_(out),
+        input_batch_(batchBuffer<InType>(max_batch)),
+        output_batch_(batchBuffer<OutType>(max_batch)),
+        thread_options_(std::move(thread_options)) {
     running_ = true;
-    proc_thread_ = ThreadType([this]() { processLoop(); });
+    launchThread();
   }
 
-  virtual ~SpeechFilter() {
-    stop();
-    if (proc_thread_.joinable()) {
-      proc_thread_.join();
-    }
+  /**
+   * @brief Creates a filter for a shared worker pool, stopped; start()
+   * attaches it.
+   * @param in The queue to read frames from.
+   * @param out The queue to write processed frames to.
+   * @param executor The pool to run on; it must outlive the filter.
+   * @param max_batch The most frames processed per processBatch() call; 1
+   * processes frames one at a time through processInto().
+   * @throws std::runtime_error If max_batch is zero, or above 1 for an input
+   * queue that only views frames in place (not a PopQueue).
+   */
+  BufferedSpeechFilter(InQueueType<InType>& in, QueueType<OutType>& out,
+                       FilterExecutor& executor, size_t max_batch = 1)
+      : FilterTask(&BufferedSpeechFilter::runTask,
+                   &BufferedSpeechFilter::parkTask,
+                   &BufferedSpeechFilter::unparkTask),
+        wait_(WaitStrategy::kYield),
+        max_batch_(checkBatch(max_batch)),
+        inQueue_(in),
+        outQueue_(out),
+        executor_(&executor),
+        input_batch_(batchBuffer<InType>(max_batch)),
+        output_batch_(batchBuffer<OutType>(max_batch)) {}
+
+  /**
+   * @brief Creates a filter that only runs when scheduler is driven, without
+   * a thread of its own.
+   * @param in The queue to read frames from.
+   * @param out The queue to write processed frames to.
+   * @param scheduler The scheduler to attach to; it must outlive the filter.
+   * @param max_batch The most frames processed per processBatch() call; 1
+   * processes frames one at a time through processInto().
+   * @throws std::runtime_error If max_batch is zero, or above 1 for an input
+   * queue that only views frames in place (not a PopQueue).
+   */
+  BufferedSpeechFilter(InQueueType<InType>& in, QueueType<OutType>& out,
+                       CooperativeScheduler& scheduler, size_t max_batch = 1)
+      : FilterTask(&BufferedSpeechFilter::runTask,
+                   &BufferedSpeechFilter::parkTask,
+                   &BufferedSpeechFilter::unparkTask),
+        wait_(WaitStrategy::kYield),
+        max_batch_(checkBatch(max_batch)),
+        inQueue_(in),
+        outQueue_(out),
+        scheduler_(&scheduler),
+        input_batch_(batchBuffer<InType>(max_batch)),
+        output_batch_(batchBuffer<OutType>(max_batch)) {
+    running_ = true;
+    scheduler_->attach(*this);
   }
 
+  // Filters must be halted before the deriving filter is destroyed, e.g. by
+  // ScopedFilter; halting here is too late to keep a worker or the filter
+  // thread out of it.
+  virtual ~BufferedSpeechFilter() { halt(); }
+
+  /**
+   * @brief Starts a stopped or finished filter: launches its thread or
+   * attaches it to its executor or scheduler. Pooled filters start here the
+   * first time.
+   */
   void start() {
+    if (finished()) {
+      stop();  // Ended by a marker; its thread exited or it is still attached
+    }
     if (!running_) {
+      if (proc_thread_.joinable()) {
+        // Joined before the reset: after stop() it may still be finishing
+        // its last frame and reading the stream state.
+        proc_thread_.join();
+      }
+      resetStream();
       running_ = true;
-      proc_thread_ = ThreadType([this] { processLoop(); });
+      if (executor_) {
+        executor_->attach(*this);
+      } else if (scheduler_) {
+        scheduler_->attach(*this);
+      } else {
+        launchThread();
+      }
     }
   }
 
-  void stop() { running_ = false; }
+  /**
+   * @brief Reports which ThreadOptions were applied when the filter thread
+   * was last started. Pooled and cooperative filters have no thread and
+   * always report success.
+   * @return The outcome of each setting.
+   */
+  const ThreadOptionsStatus& threadStatus() const { return thread_status_; }
+
+  /**
+   * @brief Accesses the filter's instrumentation.
+   *
+   * With FilterTelemetry, call telemetry().snapshot() or
+   * telemetry().processTime() from any thread to read throughput, idle and
+   * blocked time and the process time distribution while the filter runs.
+   * @return The instrumentation policy object.
+   */
+  const Telemetry& telemetry() const { return telemetry_; }
+
+  /**
+   * @brief Returns the stage this filter stamps traced frames with; unique
+   * per filter unless set with setTraceStage(). Once kMaxFilterTraceStage
+   * filters were created, later ones all share that stage.
+   * @return The trace stage.
+   */
+  uint16_t traceStage() const {
+    return trace_stage_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Changes the stage this filter stamps traced frames with, e.g. to
+   * keep stage numbers stable across runs (any thread).
+   * @param stage The trace stage, at most kMaxFilterTraceStage.
+   */
+  void setTraceStage(uint16_t stage) {
+    trace_stage_.store(stage, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Finishes the stream: processes all queued input, flushes, sends the
+   * end-of-stream marker and stops, waiting for the filter to get there.
+   *
+   * Call it once the upstream producer has pushed its last frame, and drain
+   * pipelines from source to sink. Waiting needs the output queue to be
+   * consumed. A cooperative filter is run on the calling thread until it
+   * finishes or its scheduler goes idle; if it is still blocked on a full
+   * output then, it finishes on a later run (see finished()).
+   */
+  void drain() {
+    draining_.store(true);
+    if (executor_) {
+      // Wake the filter if it is parked on its empty input.
+      if constexpr (ParkableQueue<InQueueType<InType>>) {
+        inQueue_.wake_consumer();
+      }
+      while (running_.load() && !finished_.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      stop();
+      return;
+    }
+    if (scheduler_) {
+      while (running_.load() && !finished_.load(std::memory_order_acquire) &&
+             scheduler_->runOnce()) {
+      }
+      if (finished_.load(std::memory_order_acquire)) {
+        stop();
+      }
+      return;
+    }
+    if constexpr (ParkableQueue<InQueueType<InType>>) {
+      inQueue_.wake_consumer();
+    }
+    if (proc_thread_.joinable()) {
+      proc_thread_.join();
+    }
+    running_ = false;
+  }
+
+  /**
+   * @brief Checks whether the filter finished its stream: it emitted its
+   * flushed output and end-of-stream marker after drain() or after popping a
+   * marker.
+   * @return true once the stream is finished, until the next start().
+   */
+  bool finished() const { return finished_.load(std::memory_order_acquire); }
+
+  void stop() {
+    if (executor_) {
+      if (running_.exchange(false)) {
+        executor_->detach(*this);
+      }
+      return;
+    }
+    if (scheduler_) {
+      if (running_.exchange(false)) {
+        scheduler_->detach(*this);
+      }
+      return;
+    }
+    running_ = false;
+    // Interrupt a parked filter thread so it sees running_.
+    if constexpr (ParkableQueue<InQueueType<InType>>) {
+      inQueue_.wake_consumer();
+    }
+    if constexpr (ParkableQueue<QueueType<OutType>>) {
+      outQueue_.wake_producer();
+    }
+  }
+
+  /**
+   * @brief Stops the filter and waits until nothing runs it any more: joins
+   * its thread, or waits for a worker running its turn to finish.
+   */
+  void halt() {
+    stop();
+    if (proc_thread_.joinable()) {
+      proc_thread_.join();
+    }
+  }
 
  protected:
-  virtual OutType process(const InType& input_data) = 0;
+  /**
+   * @brief Processes one frame into a caller-supplied output buffer.
+   *
+   * This is what the processing loop calls. input_data was moved out of the
+   * input queue and is not used again, so the filter may modify it; a filter
+   * with InType == OutType can transform it in place and std::swap it into
+   * output_data, handing the upstream buffer on without any allocation.
+   * output_data is the claimed output slot of a ClaimQueue, holding the frame
+   * its consumer released there or a value-initialised one, or else a
+   * moved-from buffer; the filter overwrites it.
+   * @param input_data The frame to process, owned by the loop.
+   * @param output_data The buffer to write the processed frame to.
+   */
+  virtual void processInto(InType& input_data, OutType& output_data) = 0;
+
+  /**
+   * @brief Processes one frame that stays in a PeekQueue input until this
+   * returns.
+   *
+   * Called instead of processInto() when the input queue is read in place.
+   * The default copies the frame into a reused buffer and calls processInto()
+   * on it; SpeechFilter reads it in place. Filters only read PeekQueues of
+   * copy-assignable frames, so the default always has a frame to process.
+   * @param input_data The frame to process, owned by the input queue.
+   * @param output_data The buffer to write the processed frame to.
+   */
+  virtual void processPeeked(const InType& input_data, OutType& output_data) {
+    // Never called otherwise; nextFrame() rejects such PeekQueues.
+    if constexpr (std::is_copy_assignable_v<InType>) {
+      input_buffer_ = input_data;
+      processInto(input_buffer_, output_data);
+    }
+  }
+
+  /**
+   * @brief Processes a batch of frames.
+   *
+   * Called instead of processInto() when the filter was constructed with a
+   * max_batch above one. Batches hold between one and max_batch frames, in
+   * queue order. As with processInto(), the input frames are owned by the loop;
+   * output_data holds moved-from buffers, since batches are pushed, not
+   * claimed. The default calls processInto() for each frame.
+   * @param input_data The frames to process.
+   * @param output_data Where to write the processed frames, one per input.
+   */
+  virtual void processBatch(std::span<InType> input_data,
+                            std::span<OutType> output_data) {
+    for (size_t i = 0; i < input_data.size(); ++i) {
+      processInto(input_data[i], output_data[i]);
+    }
+  }
+
+  /**
+   * @brief Emits output the filter still holds once its input has ended,
+   * e.g. the tail of an overlap-add filter.
+   *
+   * Called after the last input frame was processed, repeatedly until it
+   * returns false; every call that returns true pushes output_data
+   * downstream, before the end-of-stream marker. The default emits nothing.
+   * @param output_data A moved-from buffer to write the next frame to.
+   * @return true if output_data holds a frame to push.
+   */
+  virtual bool flush(OutType& output_data) {
+    (void)output_data;
+    return false;
+  }
 
   void processLoop() {
+    if (max_batch_ > 1) {
+      processBatchLoop();
+      return;
+    }
+    if constexpr (ClaimQueue<QueueType<OutType>>) {
+      processClaimLoop();
+      return;
+    }
+    // Reused for every frame; frames are moved in and out, never copied.
     InType input_data;
+    OutType output_data;
+    IdleBackoff idle(wait_);
 
     while (running_.load(std::memory_order_relaxed)) {
-      if (inQueue_.try_pop(input_data)) {
-        OutType output_data = process(input_data);
-        while (!outQueue_.try_push(output_data) &&
+      // Read before popping, so an empty pop really means the input ended.
+      bool draining = draining_.load(std::memory_order_acquire);
+      FrameStatus status = nextFrame(input_data, output_data);
+      if (status == FrameStatus::kEnded) {
+        finishStream();
+        return;
+      }
+      if (status == FrameStatus::kProcessed) {
+        idle.reset();
+        IdleBackoff blocked(wait_);
+        // A failed push leaves output_data untouched, so retrying is safe.
+        while (!outQueue_.try_push(std::move(output_data)) &&
                running_.load(std::memory_order_relaxed)) {
-          // Do something if push repeatedly fails (?)
+          telemetry_.blocked();
+          if (blocked.pause()) {
+            waitForSpace();
+          }
         }
+        telemetry_.unblocked();
+      } else if (draining) {
+        finishStream();
+        return;
       } else {
-        // Do something if the queue is full (?)
-        std::this_thread::yield();
+        telemetry_.waiting();
+        if (idle.pause()) {
+          waitForData();
+        }
       }
     }
   }
 
  private:
+  static constexpr bool kTraced = TracedFrame<InType> && TracedFrame<OutType>;
+
+  // Outcome of taking one input frame.
+  enum class FrameStatus {
+    kEmpty,      // The input queue was empty
+    kProcessed,  // A frame was processed into the output buffer
+    kEnded,      // The end-of-stream marker was taken
+  };
+
+  /**
+   * @brief Takes the next input frame and processes it: pops it into
+   * input_data, or reads it in place from a PeekQueue.
+   * @param input_data The buffer to pop the frame into.
+   * @param output_data The buffer to write the processed frame to.
+   * @return What was taken.
+   */
+  FrameStatus nextFrame(InType& input_data, OutType& output_data) {
+    if constexpr (PeekQueue<InQueueType<InType>>) {
+      static_assert(std::is_copy_assignable_v<InType>,
+                    "SpeechFilter can only read a PeekQueue of copy-assignable "
+                    "frames.");
+      const InType* front = inQueue_.peek();
+      if (front == nullptr) {
+        return FrameStatus::kEmpty;
+      }
+      bool ended = isEndOfStream(*front);
+      if (!ended) {
+        processFrame(*front, output_data);
+      }
+      inQueue_.release();
+      return ended ? FrameStatus::kEnded : FrameStatus::kProcessed;
+    } else {
+      if (!inQueue_.try_pop(input_data)) {
+        return FrameStatus::kEmpty;
+      }
+      if (isEndOfStream(input_data)) {
+        return FrameStatus::kEnded;
+      }
+      processFrame(input_data, output_data);
+      return FrameStatus::kProcessed;
+    }
+  }
+
+  /**
+   * @brief Runs processInto(), or processPeeked() on a frame still in the
+   * input queue, recording telemetry and stamping traced frames.
+   * @param input_data The popped frame, or a const one read in place.
+   * @param output_data The buffer to write the processed frame to.
+   */
+  template <typename Input>
+  void processFrame(Input& input_data, OutType& output_data) {
+    telemetry_.beginFrames();
+    if constexpr (kTraced) {
+      int64_t dequeued_ns = traceNow();
+      // Copied first: processInto() may modify or swap the input.
+      FrameTrace trace = input_data.trace;
+      processOne(input_data, output_data);
+      output_data.trace = trace;
+      output_data.trace.addHop(traceStage(), dequeued_ns, traceNow());
+    } else {
+      processOne(input_data, output_data);
+    }
+    telemetry_.endFrames(1);
+  }
+
+  void processOne(InType& input_data, OutType& output_data) {
+    processInto(input_data, output_data);
+  }
+
+  void processOne(const InType& input_data, OutType& output_data) {
+    processPeeked(input_data, output_data);
+  }
+
+  /**
+   * @brief Starts the filter thread, holding it back until thread_options_
+   * are applied so that no frame is processed with the default settings.
+   */
+  void launchThread() {
+    thread_configured_ = false;
+    proc_thread_ = ThreadType([this]() {
+      thread_configured_.wait(false);
+      processLoop();
+    });
+    thread_status_ = applyThreadOptions(proc_thread_, thread_options_);
+    thread_configured_ = true;
+    thread_configured_.notify_one();
+  }
+
+  /**
+   * @brief processLoop() for ClaimQueue outputs: processes each frame straight
+   * into the claimed output slot and publishes it.
+   */
+  void processClaimLoop() {
+    // Popped frames are moved in here; results never leave the output queue.
+    InType input_data;
+    IdleBackoff idle(wait_);
+    IdleBackoff blocked(wait_);
+
+    while (running_.load(std::memory_order_relaxed)) {
+      // Claiming again before commit_write() returns the same slot.
+      OutType* output_data = outQueue_.claim_write();
+      if (output_data == nullptr) {
+        telemetry_.blocked();
+        if (blocked.pause()) {
+          waitForSpace();
+        }
+        continue;
+      }
+      blocked.reset();
+      telemetry_.unblocked();
+      // Read before popping, so an empty pop really means the input ended.
+      bool draining = draining_.load(std::memory_order_acquire);
+      FrameStatus status = nextFrame(input_data, *output_data);
+      if (status == FrameStatus::kEnded) {
+        finishStream();
+        return;
+      }
+      if (status == FrameStatus::kProcessed) {
+        idle.reset();
+        outQueue_.commit_write();
+      } else if (draining) {
+        finishStream();
+        return;
+      } else {
+        telemetry_.waiting();
+        if (idle.pause()) {
+          waitForData();
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief processLoop() for filters that process frames in batches.
+   */
+  void processBatchLoop() {
+    IdleBackoff idle(wait_);
+    while (running_.load(std::memory_order_relaxed)) {
+      bool draining = draining_.load(std::memory_order_acquire);
+      size_t count = popBatch();
+      if (count == 0 && (input_ended_ || draining)) {
+        finishStream();
+        return;
+      }
+      if (count == 0) {
+        telemetry_.waiting();
+        if (idle.pause()) {
+          waitForData();
+        }
+        continue;
+      }
+      idle.reset();
+      runBatch(count);
+      IdleBackoff blocked(wait_);
+      size_t pushed = 0;
+      while (pushed < count && running_.load(std::memory_order_relaxed)) {
+        pushed += pushBatch(pushed, count);
+        if (pushed < count) {
+          telemetry_.blocked();
+          if (blocked.pause()) {
+            waitForSpace();
+          }
+        }
+      }
+      telemetry_.unblocked();
+      if (input_ended_) {
+        finishStream();
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Checks whether a popped frame is the end-of-stream marker, and
+   * remembers it if so.
+   * @param frame The popped frame.
+   * @return true for the marker.
+   */
+  bool isEndOfStream(const InType& frame) {
+    if constexpr (EndOfStream<InType>::kSupported) {
+      if (EndOfStream<InType>::isMarker(frame)) {
+        input_ended_ = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Pushes flush() output and then the end-of-stream marker through
+   * output_buffer_, without blocking.
+   * @param progressed Set to true if anything was pushed.
+   * @return true once everything was pushed, false if the output is full.
+   */
+  bool finishSome(bool& progressed) {
+    for (;;) {
+      if (output_pending_) {
+        if (!outQueue_.try_push(std::move(output_buffer_))) {
+          return false;
+        }
+        output_pending_ = false;
+        progressed = true;
+      }
+      if (flushed_) {
+        return true;
+      }
+      if (flush(output_buffer_)) {
+        output_pending_ = true;
+        continue;
+      }
+      flushed_ = true;
+      if constexpr (EndOfStream<OutType>::kSupported) {
+        output_buffer_ = EndOfStream<OutType>::marker();
+        output_pending_ = true;
+      }
+    }
+  }
+
+  /**
+   * @brief Finishes the stream on the filter thread, waiting for room in the
+   * output queue as needed, unless the filter is stopped meanwhile.
+   */
+  void finishStream() {
+    IdleBackoff blocked(wait_);
+    bool progressed = false;
+    while (!finishSome(progressed)) {
+      if (!running_.load(std::memory_order_relaxed)) {
+        return;
+      }
+      telemetry_.blocked();
+      if (blocked.pause()) {
+        waitForSpace();
+      }
+    }
+    telemetry_.unblocked();
+    finished_.store(true, std::memory_order_release);
+  }
+
+  /**
+   * @brief Clears the drain state before the filter is started again.
+   */
+  void resetStream() {
+    draining_ = false;
+    finished_ = false;
+    input_ended_ = false;
+    finishing_ = false;
+    flushed_ = false;
+    output_pending_ = false;
+    batch_size_ = 0;
+    batch_pushed_ = 0;
+  }
+
+  /**
+   * @brief Moves up to max_batch_ frames from the input queue into
+   * input_batch_, stopping at an end-of-stream marker.
+   * @return The number of frames taken, not counting a marker.
+   */
+  size_t popBatch() {
+    size_t count = 0;
+    if constexpr (BatchQueue<InQueueType<InType>>) {
+      count = inQueue_.try_pop_n(input_batch_.data(), max_batch_);
+    } else if constexpr (PopQueue<InQueueType<InType>>) {
+      while (count < max_batch_ && inQueue_.try_pop(input_batch_[count])) {
+        ++count;
+      }
+    }
+    // Frames behind an end-of-stream marker are not processed.
+    for (size_t i = 0; i < count; ++i) {
+      if (isEndOfStream(input_batch_[i])) {
+        return i;
+      }
+    }
+    return count;
+  }
+
+  /**
+   * @brief Processes the first count frames of input_batch_ into
+   * output_batch_.
+   * @param count The number of frames popped.
+   */
+  void runBatch(size_t count) {
+    telemetry_.beginFrames();
+    int64_t dequeued_ns = 0;
+    if constexpr (kTraced) {
+      dequeued_ns = traceNow();
+    }
+    processBatch(std::span<InType>(input_batch_.data(), count),
+                 std::span<OutType>(output_batch_.data(), count));
+    if constexpr (kTraced) {
+      int64_t processed_ns = traceNow();
+      for (size_t i = 0; i < count; ++i) {
+        output_batch_[i].trace = input_batch_[i].trace;
+        output_batch_[i].trace.addHop(traceStage(), dequeued_ns,
+                                      processed_ns);
+      }
+    }
+    telemetry_.endFrames(count);
+  }
+
+  /**
+   * @brief Pushes as many of output_batch_[first, last) as fit.
+   * @param first The first result not pushed yet.
+   * @param last One past the last result.
+   * @return The number of results pushed.
+   */
+  size_t pushBatch(size_t first, size_t last) {
+    if constexpr (BatchQueue<QueueType<OutType>>) {
+      return outQueue_.try_push_n(
+          std::make_move_iterator(output_batch_.data() + first), last - first);
+    } else {
+      size_t pushed = first;
+      while (pushed < last &&
+             outQueue_.try_push(std::move(output_batch_[pushed]))) {
+        ++pushed;
+      }
+      return pushed - first;
+    }
+  }
+
+  static size_t checkBatch(size_t max_batch) {
+    if (max_batch == 0) {
+      throw std::runtime_error("SpeechFilter batch size cannot be zero.");
+    }
+    if constexpr (!BatchQueue<InQueueType<InType>> &&
+                  !PopQueue<InQueueType<InType>>) {
+      if (max_batch > 1) {
+        throw std::runtime_error(
+            "SpeechFilter cannot batch frames it cannot pop by value.");
+      }
+    }
+    return max_batch;
+  }
+
+  // Batch buffers are only needed when frames are processed in batches.
+  template <typename T>
+  static std::vector<T> batchBuffer(size_t max_batch) {
+    return std::vector<T>(max_batch > 1 ? max_batch : 0);
+  }
+
+  // Input elements a pooled filter processes per turn, so one busy filter
+  // cannot starve the others on its worker.
+  static constexpr size_t kRunBudget = 32;
+
+  /**
+   * @brief Processes up to kRunBudget input elements (executor worker or
+   * cooperative scheduler).
+   * @return true if an element was consumed or a held result was pushed.
+   */
+  bool runSome() {
+    if (finished_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    bool progressed = false;
+    if (!finishing_) {
+      progressed = max_batch_ > 1 ? runSomeBatches() : runSomeFrames();
+      if (!finishing_) {
+        return progressed;
+      }
+    }
+    if (finishSome(progressed)) {
+      telemetry_.unblocked();
+      finished_.store(true, std::memory_order_release);
+    } else {
+      telemetry_.blocked();
+      stall_ = Stall::kOutput;
+    }
+    return progressed;
+  }
+
+  /**
+   * @brief runSome() for filters that process frames one at a time; sets
+   * finishing_ when the input ended.
+   * @return true if an element was consumed or a held result was pushed.
+   */
+  bool runSomeFrames() {
+    if constexpr (ClaimQueue<QueueType<OutType>>) {
+      return runSomeClaimedFrames();
+    }
+    bool progressed = false;
+    for (size_t i = 0; i < kRunBudget; ++i) {
+      if (output_pending_) {
+        if (!outQueue_.try_push(std::move(output_buffer_))) {
+          telemetry_.blocked();
+          stall_ = Stall::kOutput;
+          return progressed;  // Output full; retry on the next turn
+        }
+        telemetry_.unblocked();
+        output_pending_ = false;
+        progressed = true;
+      }
+      bool draining = draining_.load(std::memory_order_acquire);
+      FrameStatus status = nextFrame(input_buffer_, output_buffer_);
+      if (status == FrameStatus::kEmpty) {
+        finishing_ = draining;
+        if (!draining) {
+          telemetry_.waiting();
+          stall_ = Stall::kInput;
+        }
+        return progressed;
+      }
+      if (status == FrameStatus::kEnded) {
+        finishing_ = true;
+        return true;
+      }
+      output_pending_ = true;
+      progressed = true;
+    }
+    return progressed;
+  }
+
+  /**
+   * @brief runSomeFrames() for ClaimQueue outputs: processes each frame
+   * straight into the claimed output slot, so nothing is held between turns.
+   * @return true if an element was consumed.
+   */
+  bool runSomeClaimedFrames() {
+    bool progressed = false;
+    for (size_t i = 0; i < kRunBudget; ++i) {
+      OutType* output_data = outQueue_.claim_write();
+      if (output_data == nullptr) {
+        telemetry_.blocked();
+        stall_ = Stall::kOutput;
+        return progressed;  // Output full; retry on the next turn
+      }
+      telemetry_.unblocked();
+      bool draining = draining_.load(std::memory_order_acquire);
+      FrameStatus status = nextFrame(input_buffer_, *output_data);
+      if (status == FrameStatus::kEmpty) {
+        finishing_ = draining;
+        if (!draining) {
+          telemetry_.waiting();
+          stall_ = Stall::kInput;
+        }
+        return progressed;
+      }
+      if (status == FrameStatus::kEnded) {
+        finishing_ = true;
+        return true;
+      }
+      outQueue_.commit_write();
+      progressed = true;
+    }
+    return progressed;
+  }
+
+  /**
+   * @brief runSome() for filters that process frames in batches: runs whole
+   * batches until kRunBudget input elements were consumed; sets finishing_
+   * once the input ended and the last batch was pushed.
+   * @return true if a batch was consumed or held results were pushed.
+   */
+  bool runSomeBatches() {
+    bool progressed = false;
+    size_t consumed = 0;
+    while (consumed < kRunBudget) {
+      if (batch_pushed_ < batch_size_) {
+        size_t pushed = pushBatch(batch_pushed_, batch_size_);
+        batch_pushed_ += pushed;
+        progressed = progressed || pushed > 0;
+        if (batch_pushed_ < batch_size_) {
+          telemetry_.blocked();
+          stall_ = Stall::kOutput;
+          return progressed;  // Output full; retry on the next turn
+        }
+        telemetry_.unblocked();
+      }
+      if (input_ended_) {
+        finishing_ = true;
+        return true;
+      }
+      bool draining = draining_.load(std::memory_order_acquire);
+      size_t count = popBatch();
+      if (count == 0) {
+        if (input_ended_ || draining) {
+          finishing_ = true;
+          return true;
+        }
+        telemetry_.waiting();
+        stall_ = Stall::kInput;
+        return progressed;
+      }
+      runBatch(count);
+      batch_size_ = count;
+      batch_pushed_ = 0;
+      consumed += count;
+      progressed = true;
+    }
+    return progressed;
+  }
+
+  static bool runTask(FilterTask& task) {
+    return static_cast<BufferedSpeechFilter&>(task).runSome();
+  }
+
+  /**
+   * @brief Parks a pooled filter after a turn without progress on the queue
+   * its last turn stopped at (executor worker).
+   * @param task The filter.
+   * @param waker Puts the filter back on a run queue.
+   * @return false if that queue is not a WakerQueue or the filter has to run
+   * again right away.
+   */
+  static bool parkTask(FilterTask& task, const QueueWaker& waker) {
+    auto& filter = static_cast<BufferedSpeechFilter&>(task);
+    if (filter.finished_.load(std::memory_order_relaxed)) {
+      return true;  // Nothing to wait for until the next start()
+    }
+    if (filter.stall_ == Stall::kOutput) {
+      if constexpr (WakerQueue<QueueType<OutType>>) {
+        return filter.outQueue_.park_producer(waker);
+      }
+      return false;
+    }
+    if constexpr (WakerQueue<InQueueType<InType>>) {
+      if (!filter.inQueue_.park_consumer(waker)) {
+        return false;
+      }
+      // drain() wakes the input after setting draining_; this sees one.
+      if (filter.draining_.load()) {
+        filter.inQueue_.cancel_consumer_park();
+        return false;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Withdraws what parkTask() registered (any thread).
+   * @param task The filter.
+   */
+  static void unparkTask(FilterTask& task) {
+    auto& filter = static_cast<BufferedSpeechFilter&>(task);
+    if constexpr (WakerQueue<InQueueType<InType>>) {
+      filter.inQueue_.cancel_consumer_park();
+    }
+    if constexpr (WakerQueue<QueueType<OutType>>) {
+      filter.outQueue_.cancel_producer_park();
+    }
+  }
+
+  // Sleep between retries when WaitStrategy::kPark is used with a queue that
+  // cannot park.
+  static constexpr std::chrono::microseconds kParkFallbackSleep{200};
+
+  /**
+   * @brief Parks until the input queue has data or the filter is stopped.
+   */
+  void waitForData() {
+    if constexpr (ParkableQueue<InQueueType<InType>>) {
+      inQueue_.wait_for_data(
+          [this] { return !running_.load() || draining_.load(); });
+    } else {
+      std::this_thread::sleep_for(kParkFallbackSleep);
+    }
+  }
+
+  /**
+   * @brief Parks until the output queue has space or the filter is stopped.
+   */
+  void waitForSpace() {
+    if constexpr (ParkableQueue<QueueType<OutType>>) {
+      outQueue_.wait_for_space([this] { return !running_.load(); });
+    } else {
+      std::this_thread::sleep_for(kParkFallbackSleep);
+    }
+  }
+
   std::atomic<bool> running_ = false;
-  QueueType<InType>& inQueue_;
+  const WaitStrategy wait_;
+  const size_t max_batch_;
+  InQueueType<InType>& inQueue_;
   QueueType<OutType>& outQueue_;
   ThreadType proc_thread_;
+  // The pool running this filter, or nullptr if it has its own thread.
+  FilterExecutor* const executor_ = nullptr;
+  // The scheduler driving this filter, or nullptr.
+  CooperativeScheduler* const scheduler_ = nullptr;
+  // A pooled filter's reused frame buffers, and whether output_buffer_ holds a
+  // result that did not fit in the output queue yet. input_buffer_ also takes
+  // the copy processPeeked() makes by default.
+  InType input_buffer_{};
+  OutType output_buffer_{};
+  bool output_pending_ = false;
+  // Frames of the current batch, and how many results of it were pushed; a
+  // pooled filter keeps the unpushed rest for its next turn.
+  std::vector<InType> input_batch_;
+  std::vector<OutType> output_batch_;
+  size_t batch_size_ = 0;
+  size_t batch_pushed_ = 0;
+  // Drain state. draining_ is set by drain(), finished_ once the stream was
+  // finished; the rest is only touched by the thread running the filter.
+  std::atomic<bool> draining_ = false;
+  std::atomic<bool> finished_ = false;
+  // An end-of-stream marker was popped.
+  bool input_ended_ = false;
+  // A pooled filter ran out of input and is pushing its flush() output.
+  bool finishing_ = false;
+  // The queue a pooled filter's last turn stopped at; parkTask() parks on it.
+  enum class Stall { kInput, kOutput };
+  Stall stall_ = Stall::kInput;
+  // flush() returned false; only the marker may still be pending.
+  bool flushed_ = false;
+  const ThreadOptions thread_options_;
+  ThreadOptionsStatus thread_status_;
+  // Set once thread_options_ were applied to a newly started thread.
+  std::atomic<bool> thread_configured_ = false;
+  // Instrumentation; takes no space with FilterNoTelemetry.
+  [[no_unique_address]] Telemetry telemetry_;
+  std::atomic<uint16_t> trace_stage_ = detail::nextTraceStage();
+};
+
+/** @brief Base class for filters that return each processed frame from
+ * process(), which deriving filters implement. It works for any frame type,
+ * including move-only ones; everything else is as in BufferedSpeechFilter.
+ */
+template <class InType, class OutType,
+          template <typename> class QueueType = SPSCParkingQueue,
+          class Telemetry = FilterNoTelemetry,
+          template <typename> class InQueueType = QueueType>
+class SpeechFilter : public BufferedSpeechFilter<InType, OutType, QueueType,
+                                                 Telemetry, InQueueType> {
+ public:
+  using BufferedSpeechFilter<InType, OutType, QueueType, Telemetry,
+                             InQueueType>::BufferedSpeechFilter;
+
+ protected:
+  /**
+   * @brief Processes one frame and returns the result.
+   * @param input_data The frame to process.
+   * @return The processed frame.
+   */
+  virtual OutType process(const InType& input_data) = 0;
+
+  void processInto(InType& input_data, OutType& output_data) override {
+    output_data = process(input_data);
+  }
+
+  void processPeeked(const InType& input_data, OutType& output_data) override {
+    output_data = process(input_data);
+  }
+};
+
+/** @brief Owns a filter for its whole life: starts it once it is fully
+ * constructed and halts it before any part of it is destroyed.
+ *
+ * Use it as the most derived type, e.g. ScopedFilter<MyFilter> filter(in, out,
+ * executor). A pooled filter then needs no start() and can be destroyed while
+ * a worker runs it; a filter with its own thread is joined before the deriving
+ * filter's members go away.
+ * @tparam Filter A filter deriving from BufferedSpeechFilter.
+ */
+template <class Filter>
+class ScopedFilter final : public Filter {
+ public:
+  template <typename... Args>
+  explicit ScopedFilter(Args&&... args) : Filter(std::forward<Args>(args)...) {
+    this->start();
+  }
+
+  ~ScopedFilter() override { this->halt(); }
 };
-}  // namespace SpeechTools
\ No newline at end of file
+}  // namespace SpeechTools
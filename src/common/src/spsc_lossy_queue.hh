@@ -0,0 +1,283 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief A bounded Single-Producer, Single-Consumer (SPSC) lock-free queue that
+ * discards its oldest element instead of rejecting a push when full.
+ *
+ * Meant for real-time capture, where stale audio is worth less than a blocked
+ * capture thread: try_push() always succeeds, so end-to-end latency stays
+ * bounded by the capacity under CPU spikes. The consumer sees how many frames
+ * were lost through dropped(), and try_pop(value, skipped) reports the gap
+ * just before each popped element so downstream filters can conceal it.
+ *
+ * To discard, the producer advances the consumer's head_ with a
+ * compare-and-swap. The consumer marks head_ busy while it moves an element
+ * out, so the producer never discards an element that is being read. If the
+ * queue is full while the oldest element is busy, the producer drops the
+ * incoming element instead of waiting, since waiting could livelock a
+ * real-time capture thread that shares a core with the consumer. Both kinds
+ * of loss count in dropped() and in the gap try_pop() reports.
+ *
+ * The capacity is rounded up to a power of two so slots are found by masking.
+ *
+ * @tparam T The type of elements to store in the queue. T must be movable or
+ * copyable.
+ */
+template <typename T>
+class SPSCLossyQueue {
+ public:
+  using ValueType = T;
+
+  /**
+   * @brief Constructs a lossy SPSC queue with a specified capacity.
+   * @param capacity The maximum number of elements the queue can hold, rounded
+   * up to a power of two.
+   * @throws std::runtime_error If capacity is zero or cannot be rounded up.
+   */
+  explicit SPSCLossyQueue(size_t capacity) {
+    if (capacity == 0) {
+      throw std::runtime_error("SPSCLossyQueue capacity cannot be zero.");
+    }
+    if (capacity > (SIZE_MAX >> 2)) {
+      throw std::runtime_error("SPSCLossyQueue capacity too large.");
+    }
+    capacity_ = std::bit_ceil(capacity);
+    mask_ = capacity_ - 1;
+    slots_ = std::make_unique_for_overwrite<Slot[]>(capacity_);
+  }
+
+  /**
+   * @brief Destroys the queue and any elements still stored in it.
+   */
+  ~SPSCLossyQueue() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      size_t current_tail = tail_.load(std::memory_order_relaxed);
+      for (size_t pos = head_.load(std::memory_order_relaxed);
+           pos != current_tail; ++pos) {
+        std::destroy_at(element(pos));
+      }
+    }
+  }
+
+  SPSCLossyQueue(const SPSCLossyQueue&) = delete;
+  SPSCLossyQueue& operator=(const SPSCLossyQueue&) = delete;
+  SPSCLossyQueue(SPSCLossyQueue&&) = delete;
+  SPSCLossyQueue& operator=(SPSCLossyQueue&&) = delete;
+
+  /**
+   * @brief Pushes an element, discarding the oldest one if the queue is full,
+   * or the element itself if the oldest one is being popped (non-blocking,
+   * copy).
+   * @param value The element to copy into the queue.
+   * @return Always true; the signature matches the other queues.
+   */
+  bool try_push(const T& value) { return try_emplace(value); }
+
+  /**
+   * @brief Pushes an element, discarding the oldest one if the queue is full,
+   * or the element itself if the oldest one is being popped (non-blocking,
+   * move).
+   * @param value The element to move into the queue.
+   * @return Always true; the signature matches the other queues.
+   */
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  /**
+   * @brief Constructs an element in place at the back of the queue, discarding
+   * the oldest one if the queue is full, or the new one if the oldest one is
+   * being popped (non-blocking).
+   * @param args The arguments forwarded to T's constructor.
+   * @return Always true; the signature matches the other queues.
+   */
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    if (current_tail - cached_head_ >= capacity_ && !make_room(current_tail)) {
+      // The consumer is popping the oldest element; drop this one instead.
+      ++incoming_dropped_;
+      count_dropped();
+      return true;
+    }
+
+    std::construct_at(storage(current_tail), std::forward<Args>(args)...);
+    slots_[current_tail & mask_].incoming_dropped = incoming_dropped_;
+    tail_.store(current_tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Attempts to pop an element from the queue (non-blocking).
+   * @param value A reference to store the popped element.
+   * @return true if an element was successfully popped, false if the queue is
+   * empty.
+   */
+  bool try_pop(T& value) {
+    size_t skipped;
+    return try_pop(value, skipped);
+  }
+
+  /**
+   * @brief Attempts to pop an element from the queue (non-blocking) and
+   * reports the gap in front of it.
+   * @param value A reference to store the popped element.
+   * @param skipped Set to the number of elements discarded since the previous
+   * successful pop, i.e. the frames missing just before value.
+   * @return true if an element was successfully popped, false if the queue is
+   * empty.
+   */
+  bool try_pop(T& value, size_t& skipped) {
+    size_t pos = head_.load(std::memory_order_acquire);
+    for (;;) {
+      // The producer may have moved head_ past the cached tail.
+      if (pos >= cached_tail_) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (pos == cached_tail_) {
+          return false;  // Queue is empty
+        }
+      }
+      if (head_.compare_exchange_weak(pos, pos | kBusy,
+                                      std::memory_order_acquire)) {
+        break;
+      }
+      // The producer discarded the oldest element; pos now holds the new head.
+    }
+
+    T* front = element(pos);
+    value = std::move(*front);
+    std::destroy_at(front);
+    uint64_t incoming_dropped = slots_[pos & mask_].incoming_dropped;
+    head_.store(pos + 1, std::memory_order_release);
+    // Discarded oldest elements leave a gap in the positions; dropped
+    // incoming ones show in the producer's running count.
+    skipped = pos - expected_head_ +
+              static_cast<size_t>(incoming_dropped - incoming_seen_);
+    expected_head_ = pos + 1;
+    incoming_seen_ = incoming_dropped;
+    return true;
+  }
+
+  /**
+   * @brief Returns how many elements have been discarded to make room.
+   * @return The cumulative dropped element count (any thread).
+   */
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Returns the approximate number of elements currently in the queue.
+   * @return The current size of the queue.
+   */
+  size_t size() const {
+    size_t current_head = head_.load(std::memory_order_acquire) & ~kBusy;
+    size_t current_tail = tail_.load(std::memory_order_acquire);
+    return current_tail > current_head
+               ? std::min(current_tail - current_head, capacity_)
+               : 0;
+  }
+
+  /**
+   * @brief Checks if the queue is empty.
+   * @return true if the queue contains no elements, false otherwise.
+   */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Checks if the queue is full, i.e. the next push discards an
+   * element.
+   * @return true if the queue has reached its maximum capacity, false
+   * otherwise.
+   */
+  bool full() const { return size() == capacity_; }
+
+  /**
+   * @brief Returns the maximum number of elements the queue can hold.
+   * @return The capacity, after power-of-two rounding.
+   */
+  size_t capacity() const { return capacity_; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+  // Set in head_ while the consumer moves the element at head_ out.
+  static constexpr size_t kBusy = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+  // Raw storage for one element; only positions in [head_, tail_) hold a live
+  // T.
+  struct Slot {
+    alignas(T) std::byte storage[sizeof(T)];
+    // The producer's incoming_dropped_ when the element was pushed.
+    uint64_t incoming_dropped;
+  };
+
+  /**
+   * @brief Frees the slot at current_tail, discarding the oldest element if
+   * the consumer has not popped it (producer). Never waits.
+   * @param current_tail The position about to be written.
+   * @return true if the slot is free, false if the consumer is popping the
+   * oldest element right now.
+   */
+  bool make_room(size_t current_tail) {
+    size_t head = head_.load(std::memory_order_acquire);
+    for (;;) {
+      size_t pos = head & ~kBusy;
+      if (current_tail - pos < capacity_) {
+        cached_head_ = pos;  // The consumer freed a slot meanwhile
+        return true;
+      }
+      if (head & kBusy) {
+        return false;
+      }
+      if (head_.compare_exchange_weak(head, head + 1,
+                                      std::memory_order_acq_rel)) {
+        std::destroy_at(element(head));
+        count_dropped();
+        cached_head_ = head + 1;
+        return true;
+      }
+    }
+  }
+
+  /**
+   * @brief Counts one discarded element (producer).
+   */
+  void count_dropped() {
+    dropped_.store(dropped_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+  }
+
+  T* storage(size_t index) {
+    return reinterpret_cast<T*>(slots_[index & mask_].storage);
+  }
+
+  T* element(size_t index) { return std::launder(storage(index)); }
+
+  // Read-only after construction.
+  size_t capacity_ = 0;
+  size_t mask_ = 0;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Read position: advanced by the consumer, and by the producer when it
+  // discards. Next to the consumer's private state.
+  alignas(kCacheLineSize) std::atomic<size_t> head_ = 0;
+  size_t cached_tail_ = 0;
+  // Position the consumer expects to pop next if nothing is discarded.
+  size_t expected_head_ = 0;
+  // incoming_dropped of the last popped slot.
+  uint64_t incoming_seen_ = 0;
+
+  // Producer-owned write position and its private state.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_ = 0;
+  size_t cached_head_ = 0;
+  // Incoming elements dropped because the oldest one was being popped.
+  uint64_t incoming_dropped_ = 0;
+  // Written by the producer only.
+  std::atomic<uint64_t> dropped_ = 0;
+};
@@ -1,9 +1,51 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <span>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <utility>
 
+#include "queue_stats.hh"
+#include "queue_waker.hh"
+
+/**
+ * @brief Selects how BasicSPSCLockFreeQueue maps its indices onto buffer slots.
+ */
+enum class SPSCIndexing {
+  // Indices wrap with a modulo over capacity + 1 slots; one slot is kept empty
+  // to tell a full queue from an empty one.
+  kModulo,
+  // Capacity is rounded up to a power of two. Indices are free-running
+  // counters masked onto the buffer, so every slot is usable and size() is
+  // exact.
+  kPowerOfTwo,
+};
+
+/**
+ * @brief Selects how BasicSPSCLockFreeQueue's blocking operations wait.
+ */
+enum class SPSCBlocking {
+  // push()/pop() retry with std::this_thread::yield() and nothing ever parks,
+  // so publishing needs no fence, but a thread waiting in them keeps a core
+  // busy. The queue's default: for queues only used through try_* or by
+  // threads that spin or yield anyway.
+  kYield,
+  // push()/pop() park with std::atomic::wait. Every publish then checks
+  // whether the other side is parked, behind a store-load fence. For queues
+  // whose threads really sleep; SpeechFilter's default queue uses it.
+  kPark,
+};
+
 /**
  * @brief A Single-Producer, Single-Consumer (SPSC) lock-free queue.
  *
@@ -12,38 +54,104 @@
  * buffer and atomic operations for its head and tail pointers to avoid
  * mutex overhead, making it suitable for real-time and embedded systems.
  *
+ * Slots are raw aligned storage: an element is constructed in place when it is
+ * pushed and destroyed when it is popped, so empty slots hold no resources and
+ * T need not be default constructible. The one exception is the zero-copy
+ * path: release_read() leaves the element alive in its slot and the next
+ * claim_write() of that slot hands it to the producer, so buffers such as a
+ * frame vector's capacity are reused without allocating. The price is memory:
+ * once that path went around the ring, every slot keeps its last element, so
+ * a queue of frames holds one frame per slot (capacity() + 1 in kModulo mode)
+ * until the queue is destroyed. Queues used through push/pop only never
+ * retain anything.
+ *
+ * By default push()/pop() yield between retries, which saves the fence below
+ * but does not lower idle CPU. With SPSCBlocking::kPark (SPSCParkingQueue, the
+ * queue SpeechFilter uses unless told otherwise) they park the calling thread
+ * with std::atomic::wait on its parked flag. Each side advertises that it is
+ * parked, so the other side only pays for clearing the flag and a
+ * notify_one() when someone is actually waiting. wake_consumer()/
+ * wake_producer() clear the flag from any thread, so a filter being stopped
+ * can interrupt a parked thread. Checking the flag costs a store-load fence on
+ * every publish, including try_push() and try_pop(), so only queues whose
+ * threads really park should pay for it. A side that is not a thread, such as
+ * a filter on a FilterExecutor, parks with park_consumer()/park_producer()
+ * instead: the other side then calls its QueueWaker rather than waking a
+ * thread.
+ *
+ * Code normally names it through SPSCLockFreeQueue<T> (the default policies)
+ * or one of the aliases below. Those take exactly one parameter, so they bind
+ * to single-parameter template template parameters such as SpeechFilter's
+ * QueueType on every compiler, without relaxed template template matching.
+ *
  * @tparam T The type of elements to store in the queue. T must be movable or
- * copyable.
+ * copyable; try_pop() additionally needs it to be move assignable.
+ * @tparam Indexing The index-to-slot mapping, see SPSCIndexing.
+ * @tparam Stats The instrumentation policy, SPSCNoStats (no cost) or
+ * SPSCQueueStats; see stats().
+ * @tparam Blocking How blocking operations wait, see SPSCBlocking. Only
+ * kPark queues have wait_for_data()/wait_for_space() and wake_consumer()/
+ * wake_producer().
  */
-template <typename T>
-class SPSCLockFreeQueue {
+template <typename T, SPSCIndexing Indexing = SPSCIndexing::kModulo,
+          typename Stats = SPSCNoStats,
+          SPSCBlocking Blocking = SPSCBlocking::kYield>
+class BasicSPSCLockFreeQueue {
+  static constexpr bool kPowerOfTwo = Indexing == SPSCIndexing::kPowerOfTwo;
+  static constexpr bool kParking = Blocking == SPSCBlocking::kPark;
+  // Elements with no destructor own no storage worth keeping, so released
+  // slots are only tracked for the others.
+  static constexpr bool kRetains = !std::is_trivially_destructible_v<T>;
+
  public:
   using ValueType = T;
 
   /**
    * @brief Constructs an SPSC queue with a specified capacity.
-   * @param capacity The maximum number of elements the queue can hold.
-   * @throws std::runtime_error If capacity is zero.
+   * @param capacity The maximum number of elements the queue can hold. In
+   * SPSCIndexing::kPowerOfTwo mode this is rounded up to a power of two.
+   * @throws std::runtime_error If capacity is zero or cannot be rounded up.
    */
-  explicit SPSCLockFreeQueue(size_t capacity)
-      : buffer_(std::make_unique<T[]>(capacity + 1)),  // Allocate N+1 slots
-        capacity_(capacity)  // Store N as usable capacity
-  {
+  explicit BasicSPSCLockFreeQueue(size_t capacity)
+      : capacity_(usable_capacity(capacity)),  // Store N as usable capacity
+        mask_(capacity_ - 1),
+        // Allocate uninitialised slots
+        buffer_(std::make_unique_for_overwrite<Slot[]>(slot_count())),
+        retained_(kRetains ? std::make_unique<bool[]>(slot_count()) : nullptr) {
     if (capacity == 0) {
       throw std::runtime_error("SPSCLockFreeQueue capacity cannot be zero.");
     }
   }
 
+  /**
+   * @brief Destroys the queue and any elements still stored in it.
+   */
+  ~BasicSPSCLockFreeQueue() {
+    if constexpr (kRetains) {
+      size_t current_head = head_.load(std::memory_order_relaxed);
+      size_t current_tail = tail_.load(std::memory_order_relaxed);
+      for (; current_head != current_tail;
+           current_head = next_index(current_head)) {
+        std::destroy_at(element(current_head));
+      }
+      for (size_t i = 0; i < slot_count(); ++i) {
+        if (retained_[i]) {
+          std::destroy_at(element(i));
+        }
+      }
+    }
+  }
+
   // Delete copy constructor and assignment operator to prevent accidental
   // copies and ensure single ownership/instance behavior.
-  SPSCLockFreeQueue(const SPSCLockFreeQueue&) = delete;
-  SPSCLockFreeQueue& operator=(const SPSCLockFreeQueue&) = delete;
+  BasicSPSCLockFreeQueue(const BasicSPSCLockFreeQueue&) = delete;
+  BasicSPSCLockFreeQueue& operator=(const BasicSPSCLockFreeQueue&) = delete;
 
   // Delete move constructor and assignment operator for simplicity and to avoid
   // complications with `const capacity_` and atomic state transfer.
   // The queue is typically constructed once and used.
-  SPSCLockFreeQueue(SPSCLockFreeQueue&&) = delete;
-  SPSCLockFreeQueue& operator=(SPSCLockFreeQueue&&) = delete;
+  BasicSPSCLockFreeQueue(BasicSPSCLockFreeQueue&&) = delete;
+  BasicSPSCLockFreeQueue& operator=(BasicSPSCLockFreeQueue&&) = delete;
 
   /**
    * @brief Attempts to push an element into the queue (non-blocking, copy).
@@ -51,23 +159,7 @@ class SPSCLockFreeQueue {
    * @return true if the element was successfully pushed, false if the queue is
    * full.
    */
-  bool try_push(const T& value) {
-    size_t current_tail = tail_.load(std::memory_order_relaxed);
-    size_t next_tail = next_index(current_tail);
-
-    // Check if the queue is full by comparing the next write position with the
-    // read position. Use acquire memory order for head_ to ensure visibility of
-    // consumer's progress.
-    if (next_tail == head_.load(std::memory_order_acquire)) {
-      return false;  // Queue is full
-    }
-
-    buffer_[current_tail] = value;  // Copy assignment
-    // Release memory order for tail_ to ensure the value written is visible
-    // to the consumer before the consumer sees the updated tail_.
-    tail_.store(next_tail, std::memory_order_release);
-    return true;
-  }
+  bool try_push(const T& value) { return try_emplace(value); }
 
   /**
    * @brief Attempts to push an element into the queue (non-blocking, move).
@@ -75,17 +167,34 @@ class SPSCLockFreeQueue {
    * @return true if the element was successfully pushed, false if the queue is
    * full.
    */
-  bool try_push(T&& value) {
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  /**
+   * @brief Attempts to construct an element in place at the back of the queue
+   * (non-blocking).
+   * @param args The arguments forwarded to T's constructor. They are left
+   * untouched if the queue is full.
+   * @return true if the element was successfully pushed, false if the queue is
+   * full.
+   */
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
     size_t current_tail = tail_.load(std::memory_order_relaxed);
-    size_t next_tail = next_index(current_tail);
 
-    // Check if the queue is full.
-    if (next_tail == head_.load(std::memory_order_acquire)) {
+    // Check if the queue is full by comparing the write position with the
+    // read position. The cached copy of head_ is only refreshed, with acquire
+    // memory order for visibility of the consumer's progress, when it says the
+    // queue is full.
+    if (is_full(cached_head_, current_tail) &&
+        is_full(refresh_head(), current_tail)) {
+      stats_.push_failed();
       return false;  // Queue is full
     }
 
-    buffer_[current_tail] = std::move(value);  // Move assignment
-    tail_.store(next_tail, std::memory_order_release);
+    std::construct_at(free_storage(current_tail), std::forward<Args>(args)...);
+    // Release memory order for tail_ to ensure the value written is visible
+    // to the consumer before the consumer sees the updated tail_.
+    publish_tail(next_index(current_tail));
     return true;
   }
 
@@ -98,35 +207,512 @@ class SPSCLockFreeQueue {
   bool try_pop(T& value) {
     size_t current_head = head_.load(std::memory_order_relaxed);
     // Check if the queue is empty by comparing the read position with the write
-    // position. Use acquire memory order for tail_ to ensure visibility of
-    // producer's written data.
-    if (current_head == tail_.load(std::memory_order_acquire)) {
+    // position. The cached copy of tail_ is only refreshed, with acquire memory
+    // order for visibility of the producer's written data, when it says the
+    // queue is empty.
+    if (current_head == cached_tail_ && current_head == refresh_tail()) {
+      stats_.pop_failed();
       return false;  // Queue is empty
     }
 
-    value = std::move(buffer_[current_head]);  // Move element out
+    T* front = element(current_head);
+    value = std::move(*front);  // Move element out
+    std::destroy_at(front);
     // Release memory order for head_ to ensure the read is complete and the
     // slot is logically free before the producer sees the updated head_.
-    head_.store(next_index(current_head), std::memory_order_release);
+    publish_head(next_index(current_head));
     return true;
   }
 
+  /**
+   * @brief Attempts to push up to count elements into the queue
+   * (non-blocking, copy).
+   *
+   * All transferred elements are published to the consumer with a single
+   * release store of tail_. Wrap the range in std::make_move_iterator to move
+   * elements in instead of copying them.
+   * @param first Iterator to the first element to push.
+   * @param count The number of elements available from first.
+   * @return The number of elements pushed, 0 if the queue is full.
+   */
+  template <std::input_iterator InputIt>
+  size_t try_push_n(InputIt first, size_t count) {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    size_t free_slots = capacity_ - used_slots(cached_head_, current_tail);
+    if (free_slots < count) {
+      free_slots = capacity_ - used_slots(refresh_head(), current_tail);
+    }
+    size_t n = std::min(count, free_slots);
+
+    for (size_t i = 0; i < n; ++i, ++first) {
+      std::construct_at(free_storage(current_tail), *first);
+      current_tail = next_index(current_tail);
+    }
+    if (n > 0) {
+      publish_tail(current_tail);
+    } else if (count > 0) {
+      stats_.push_failed();
+    }
+    return n;
+  }
+
+  /**
+   * @brief Attempts to push a span of elements into the queue (non-blocking,
+   * copy).
+   * @param values The elements to copy into the queue.
+   * @return The number of leading elements of values that were pushed.
+   */
+  size_t try_push_n(std::span<const T> values) {
+    return try_push_n(values.begin(), values.size());
+  }
+
+  /**
+   * @brief Attempts to pop up to max_count elements from the queue
+   * (non-blocking).
+   *
+   * The freed slots are handed back to the producer with a single release
+   * store of head_.
+   * @param out Output iterator the popped elements are moved into.
+   * @param max_count The maximum number of elements to pop.
+   * @return The number of elements popped, 0 if the queue is empty.
+   */
+  template <std::output_iterator<T> OutputIt>
+  size_t try_pop_n(OutputIt out, size_t max_count) {
+    size_t current_head = head_.load(std::memory_order_relaxed);
+    size_t available = used_slots(current_head, cached_tail_);
+    if (available < max_count) {
+      available = used_slots(current_head, refresh_tail());
+    }
+    size_t n = std::min(max_count, available);
+
+    for (size_t i = 0; i < n; ++i, ++out) {
+      T* front = element(current_head);
+      *out = std::move(*front);
+      std::destroy_at(front);
+      current_head = next_index(current_head);
+    }
+    if (n > 0) {
+      publish_head(current_head);
+    } else if (max_count > 0) {
+      stats_.pop_failed();
+    }
+    return n;
+  }
+
+  /**
+   * @brief Attempts to pop enough elements to fill a span (non-blocking).
+   * @param values The destination the popped elements are moved into.
+   * @return The number of leading elements of values that were filled.
+   */
+  size_t try_pop_n(std::span<T> values) {
+    return try_pop_n(values.begin(), values.size());
+  }
+
+  /**
+   * @brief Claims the next free slot for in-place writing, reusing the element
+   * in it (non-blocking).
+   *
+   * If the consumer handed the slot back with release_read(), the element it
+   * released is returned as the consumer left it, for the producer to
+   * overwrite in place and reuse its storage (e.g. a vector's capacity). So
+   * once every slot went around once, a claim/peek flow allocates nothing.
+   * Otherwise a value-initialised element is constructed in the slot; for
+   * trivially destructible T there is no storage to reuse and it always is.
+   * The slot becomes visible to the consumer on commit_write(); claiming again
+   * before that returns the same element.
+   * @return A pointer to the claimed element, or nullptr if the queue is full.
+   */
+  T* claim_write()
+    requires std::default_initializable<T>
+  {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    if (is_full(cached_head_, current_tail) &&
+        is_full(refresh_head(), current_tail)) {
+      stats_.push_failed();
+      return nullptr;  // Queue is full
+    }
+    if constexpr (kRetains) {
+      bool& retained = retained_[slot(current_tail)];
+      if (retained) {
+        return element(current_tail);
+      }
+      retained = true;  // Until commit_write()
+    }
+    return std::construct_at(storage(current_tail));
+  }
+
+  /**
+   * @brief Claims the next free slot for in-place writing, with a new element
+   * constructed from args (non-blocking).
+   *
+   * An element left in the slot by release_read() or an earlier claim is
+   * destroyed first. Otherwise as claim_write().
+   * @param args The arguments forwarded to T's constructor. They are left
+   * untouched if the queue is full.
+   * @return A pointer to the claimed element, or nullptr if the queue is full.
+   */
+  template <typename... Args>
+  T* claim_write_fresh(Args&&... args) {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    if (is_full(cached_head_, current_tail) &&
+        is_full(refresh_head(), current_tail)) {
+      stats_.push_failed();
+      return nullptr;  // Queue is full
+    }
+    T* claimed = std::construct_at(free_storage(current_tail),
+                                   std::forward<Args>(args)...);
+    if constexpr (kRetains) {
+      retained_[slot(current_tail)] = true;  // Until commit_write()
+    }
+    return claimed;
+  }
+
+  /**
+   * @brief Publishes the slot returned by the last successful claim_write().
+   */
+  void commit_write() {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    if constexpr (kRetains) {
+      retained_[slot(current_tail)] = false;
+    }
+    publish_tail(next_index(current_tail));
+  }
+
+  /**
+   * @brief Accesses the oldest element in place (non-blocking).
+   *
+   * The element stays in the queue until release_read() is called.
+   * @return A pointer to the oldest element, or nullptr if the queue is empty.
+   */
+  T* peek_read() {
+    size_t current_head = head_.load(std::memory_order_relaxed);
+    if (current_head == cached_tail_ && current_head == refresh_tail()) {
+      stats_.pop_failed();
+      return nullptr;  // Queue is empty
+    }
+    return element(current_head);
+  }
+
+  /**
+   * @brief Hands the slot returned by the last successful peek_read() back to
+   * the producer.
+   *
+   * The element stays alive in the slot, in whatever state the consumer left
+   * it, until the producer claims the slot with claim_write() and reuses it,
+   * or pushes over it or claims it with claim_write_fresh(), which destroy it
+   * first. Whatever the element owns stays allocated until then.
+   */
+  void release_read() {
+    size_t current_head = head_.load(std::memory_order_relaxed);
+    if constexpr (kRetains) {
+      retained_[slot(current_head)] = true;
+    }
+    publish_head(next_index(current_head));
+  }
+
+  /**
+   * @brief Pushes an element into the queue, blocking while it is full (copy).
+   * @param value The element to copy into the queue.
+   */
+  void push(const T& value) {
+    while (!try_push(value)) {
+      await_space();
+    }
+  }
+
+  /**
+   * @brief Pushes an element into the queue, blocking while it is full (move).
+   * @param value The element to move into the queue.
+   */
+  void push(T&& value) {
+    // try_push only moves from value once it has claimed a slot.
+    while (!try_push(std::move(value))) {
+      await_space();
+    }
+  }
+
+  /**
+   * @brief Constructs an element in place at the back of the queue, blocking
+   * while it is full.
+   * @param args The arguments forwarded to T's constructor.
+   */
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    // try_emplace only consumes args once it has claimed a slot.
+    while (!try_emplace(std::forward<Args>(args)...)) {
+      await_space();
+    }
+  }
+
+  /**
+   * @brief Pops an element from the queue, blocking while it is empty.
+   * @param value A reference to store the popped element.
+   */
+  void pop(T& value) {
+    while (!try_pop(value)) {
+      await_data();
+    }
+  }
+
+  /**
+   * @brief Pushes an element, waiting at most timeout for space (copy).
+   * @param value The element to copy into the queue.
+   * @param timeout The maximum time to wait.
+   * @return true if the element was pushed, false on timeout.
+   */
+  template <typename Rep, typename Period>
+  bool push_for(const T& value,
+                const std::chrono::duration<Rep, Period>& timeout) {
+    return push_until(value, std::chrono::steady_clock::now() + timeout);
+  }
+
+  /**
+   * @brief Pushes an element, waiting at most timeout for space (move).
+   * @param value The element to move into the queue. Left untouched on
+   * timeout.
+   * @param timeout The maximum time to wait.
+   * @return true if the element was pushed, false on timeout.
+   */
+  template <typename Rep, typename Period>
+  bool push_for(T&& value, const std::chrono::duration<Rep, Period>& timeout) {
+    return push_until(std::move(value),
+                      std::chrono::steady_clock::now() + timeout);
+  }
+
+  /**
+   * @brief Pushes an element, waiting until deadline for space (copy).
+   * @param value The element to copy into the queue.
+   * @param deadline The point in time after which to give up.
+   * @return true if the element was pushed, false on timeout.
+   */
+  template <typename Clock, typename Duration>
+  bool push_until(const T& value,
+                  const std::chrono::time_point<Clock, Duration>& deadline) {
+    return retry_until(deadline, [&] { return try_push(value); });
+  }
+
+  /**
+   * @brief Pushes an element, waiting until deadline for space (move).
+   * @param value The element to move into the queue. Left untouched on
+   * timeout.
+   * @param deadline The point in time after which to give up.
+   * @return true if the element was pushed, false on timeout.
+   */
+  template <typename Clock, typename Duration>
+  bool push_until(T&& value,
+                  const std::chrono::time_point<Clock, Duration>& deadline) {
+    return retry_until(deadline, [&] { return try_push(std::move(value)); });
+  }
+
+  /**
+   * @brief Pops an element, waiting at most timeout for one to arrive.
+   * @param value A reference to store the popped element.
+   * @param timeout The maximum time to wait.
+   * @return true if an element was popped, false on timeout.
+   */
+  template <typename Rep, typename Period>
+  bool pop_for(T& value, const std::chrono::duration<Rep, Period>& timeout) {
+    return pop_until(value, std::chrono::steady_clock::now() + timeout);
+  }
+
+  /**
+   * @brief Pops an element, waiting until deadline for one to arrive.
+   * @param value A reference to store the popped element.
+   * @param deadline The point in time after which to give up.
+   * @return true if an element was popped, false on timeout.
+   */
+  template <typename Clock, typename Duration>
+  bool pop_until(T& value,
+                 const std::chrono::time_point<Clock, Duration>& deadline) {
+    return retry_until(deadline, [&] { return try_pop(value); });
+  }
+
+  /**
+   * @brief Parks the consumer until the queue is non-empty, wake_consumer() is
+   * called, or cancelled() returns true (consumer).
+   *
+   * Returns immediately if there is data or cancelled() is already true. The
+   * parked flag is published before tail_ and cancelled() are re-read,
+   * pairing with the fence in wake(), so a push or wake_consumer() either sees
+   * the flag or the consumer sees its effect and does not sleep. For that,
+   * whatever cancelled() reads must be stored before calling wake_consumer()
+   * and loaded with seq_cst.
+   * @param cancelled A predicate that ends the wait when it returns true.
+   */
+  template <typename Cancelled>
+    requires kParking
+  void wait_for_data(Cancelled&& cancelled) {
+    size_t current_head = head_.load(std::memory_order_relaxed);
+    consumer_parked_.store(true, std::memory_order_seq_cst);
+    if (tail_.load(std::memory_order_seq_cst) == current_head && !cancelled()) {
+      consumer_parked_.wait(true, std::memory_order_acquire);
+    }
+    consumer_parked_.store(false, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Parks the consumer until the queue is non-empty or wake_consumer()
+   * is called (consumer).
+   */
+  void wait_for_data()
+    requires kParking
+  {
+    wait_for_data([] { return false; });
+  }
+
+  /**
+   * @brief Parks the producer until the queue has space, wake_producer() is
+   * called, or cancelled() returns true (producer).
+   *
+   * Mirrors wait_for_data(); a pop or wake_producer() ends the wait.
+   * @param cancelled A predicate that ends the wait when it returns true.
+   */
+  template <typename Cancelled>
+    requires kParking
+  void wait_for_space(Cancelled&& cancelled) {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    producer_parked_.store(true, std::memory_order_seq_cst);
+    if (is_full(head_.load(std::memory_order_seq_cst), current_tail) &&
+        !cancelled()) {
+      producer_parked_.wait(true, std::memory_order_acquire);
+    }
+    producer_parked_.store(false, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Parks the producer until the queue has space or wake_producer() is
+   * called (producer).
+   */
+  void wait_for_space()
+    requires kParking
+  {
+    wait_for_space([] { return false; });
+  }
+
+  /**
+   * @brief Parks the consumer without blocking a thread: the next push or
+   * wake_consumer() calls waker instead of waking a thread (consumer).
+   *
+   * For consumers that are not threads, such as filters on a FilterExecutor.
+   * As in wait_for_data(), the registration is published before tail_ is
+   * re-read, so a push either sees it or this sees the push.
+   * @param waker Called once, from the thread that ends the wait. It must stay
+   * valid until then or until cancel_consumer_park() returns.
+   * @return true if parked; false if the queue has data, in which case waker
+   * is not called.
+   */
+  bool park_consumer(const QueueWaker& waker)
+    requires kParking
+  {
+    size_t current_head = head_.load(std::memory_order_relaxed);
+    consumer_waker_.store(&waker, std::memory_order_seq_cst);
+    if (tail_.load(std::memory_order_seq_cst) == current_head) {
+      return true;
+    }
+    // Data arrived meanwhile; withdraw, unless a push already took the waker.
+    return consumer_waker_.exchange(nullptr) == nullptr;
+  }
+
+  /**
+   * @brief Parks the producer without blocking a thread: the next pop or
+   * wake_producer() calls waker instead of waking a thread (producer).
+   *
+   * Mirrors park_consumer().
+   * @param waker Called once, from the thread that ends the wait. It must stay
+   * valid until then or until cancel_producer_park() returns.
+   * @return true if parked; false if the queue has space, in which case waker
+   * is not called.
+   */
+  bool park_producer(const QueueWaker& waker)
+    requires kParking
+  {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    producer_waker_.store(&waker, std::memory_order_seq_cst);
+    if (is_full(head_.load(std::memory_order_seq_cst), current_tail)) {
+      return true;
+    }
+    return producer_waker_.exchange(nullptr) == nullptr;
+  }
+
+  /**
+   * @brief Withdraws a park_consumer() registration, waiting for a call of its
+   * waker that is already under way (any thread). Once this returns, the
+   * waker is not used any more.
+   */
+  void cancel_consumer_park()
+    requires kParking
+  {
+    cancel_park(consumer_waker_);
+  }
+
+  /**
+   * @brief Withdraws a park_producer() registration; see
+   * cancel_consumer_park().
+   */
+  void cancel_producer_park()
+    requires kParking
+  {
+    cancel_park(producer_waker_);
+  }
+
+  /**
+   * @brief Wakes the consumer if it is parked in pop() or wait_for_data(),
+   * or calls its park_consumer() waker (any thread). pop() goes back to sleep
+   * if the queue is still empty.
+   */
+  void wake_consumer()
+    requires kParking
+  {
+    wake(consumer_parked_, consumer_waker_);
+  }
+
+  /**
+   * @brief Wakes the producer if it is parked in push(), emplace() or
+   * wait_for_space(), or calls its park_producer() waker (any thread). push()
+   * and emplace() go back to sleep if the queue is still full.
+   */
+  void wake_producer()
+    requires kParking
+  {
+    wake(producer_parked_, producer_waker_);
+  }
+
   /**
    * @brief Returns the approximate number of elements currently in the queue.
    * @note This is an approximation in a lock-free SPSC queue without a separate
    * counter, as head and tail can be updated concurrently by different threads.
+   * In SPSCIndexing::kPowerOfTwo mode it is the plain difference of the
+   * free-running counters, clamped to capacity().
    * @return The current size of the queue.
    */
   size_t size() const {
-    size_t current_head = head_.load(std::memory_order_relaxed);
-    size_t current_tail = tail_.load(std::memory_order_relaxed);
-    if (current_tail >= current_head) {
-      return current_tail - current_head;
+    if constexpr (kPowerOfTwo) {
+      // Load head_ first: tail_ can only have moved further ahead since.
+      size_t current_head = head_.load(std::memory_order_acquire);
+      size_t current_tail = tail_.load(std::memory_order_acquire);
+      return std::min(current_tail - current_head, capacity_);
     } else {
-      return capacity_ + current_tail - current_head;
+      size_t current_head = head_.load(std::memory_order_relaxed);
+      size_t current_tail = tail_.load(std::memory_order_relaxed);
+      return used_slots(current_head, current_tail);
     }
   }
 
+  /**
+   * @brief Returns the maximum number of elements the queue can hold.
+   * @return The usable capacity, after any power-of-two rounding.
+   */
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * @brief Accesses the instrumentation counters.
+   *
+   * With SPSCQueueStats, call stats().snapshot() from any thread to read
+   * full/empty failure counts, peak occupancy and stall times.
+   * @return The instrumentation policy object.
+   */
+  const Stats& stats() const { return stats_; }
+
   /**
    * @brief Checks if the queue is empty.
    * @return true if the queue contains no elements, false otherwise.
@@ -144,24 +730,342 @@ class SPSCLockFreeQueue {
    */
   bool full() const {
     // Use acquire memory order to ensure visibility of the latest head_ update.
-    return next_index(tail_.load(std::memory_order_acquire)) ==
-           head_.load(std::memory_order_acquire);
+    return is_full(head_.load(std::memory_order_acquire),
+                   tail_.load(std::memory_order_acquire));
   }
 
  private:
+  /**
+   * @brief Calculates the usable capacity for a requested capacity.
+   * @param capacity The requested capacity.
+   * @return capacity, rounded up to a power of two in kPowerOfTwo mode.
+   * @throws std::runtime_error If capacity cannot be rounded up.
+   */
+  static size_t usable_capacity(size_t capacity) {
+    if constexpr (kPowerOfTwo) {
+      if (capacity > (SIZE_MAX >> 1) + 1) {
+        throw std::runtime_error(
+            "SPSCLockFreeQueue capacity too large to round to a power of two.");
+      }
+      return std::bit_ceil(capacity);
+    } else {
+      return capacity;
+    }
+  }
+
+  /**
+   * @brief Returns the number of slots backing the queue.
+   * @return capacity_ + 1 in kModulo mode, capacity_ in kPowerOfTwo mode.
+   */
+  size_t slot_count() const { return kPowerOfTwo ? capacity_ : capacity_ + 1; }
+
+  /**
+   * @brief Maps an index onto its buffer slot.
+   * @param index A head or tail index.
+   * @return The position of index in buffer_.
+   */
+  size_t slot(size_t index) const {
+    if constexpr (kPowerOfTwo) {
+      return index & mask_;
+    } else {
+      return index;
+    }
+  }
+
+  /**
+   * @brief Returns the raw storage of the slot for an index, to construct an
+   * element in.
+   * @param index A tail index.
+   * @return A pointer to the slot's uninitialised storage.
+   */
+  T* storage(size_t index) {
+    return reinterpret_cast<T*>(buffer_[slot(index)].storage);
+  }
+
+  /**
+   * @brief Returns the raw storage of a free slot, destroying the element
+   * release_read() left in it, if any (producer).
+   * @param index A tail index.
+   * @return A pointer to the slot's uninitialised storage.
+   */
+  T* free_storage(size_t index) {
+    if constexpr (kRetains) {
+      bool& retained = retained_[slot(index)];
+      if (retained) {
+        std::destroy_at(element(index));
+        retained = false;
+      }
+    }
+    return storage(index);
+  }
+
+  /**
+   * @brief Returns the live element in the slot for an index.
+   * @param index A head index whose slot holds a constructed element.
+   * @return A pointer to the element.
+   */
+  T* element(size_t index) { return std::launder(storage(index)); }
+
   /**
    * @brief Calculates the next index in the circular buffer.
    * @param current_index The current index.
-   * @return The next index, wrapping around if necessary.
+   * @return The next index, wrapping around if necessary. Free-running
+   * counters in kPowerOfTwo mode simply increment.
    */
   size_t next_index(size_t current_index) const {
-    return (current_index + 1) % (capacity_ + 1);
+    if constexpr (kPowerOfTwo) {
+      return current_index + 1;
+    } else {
+      return (current_index + 1) % (capacity_ + 1);
+    }
+  }
+
+  /**
+   * @brief Calculates the number of occupied slots between two indices.
+   * @param head The read index.
+   * @param tail The write index.
+   * @return The number of elements stored between head and tail.
+   */
+  size_t used_slots(size_t head, size_t tail) const {
+    if constexpr (kPowerOfTwo) {
+      return tail - head;
+    } else {
+      return tail >= head ? tail - head : capacity_ + 1 + tail - head;
+    }
+  }
+
+  /**
+   * @brief Checks whether the queue is full for a pair of indices.
+   * @param head The read index.
+   * @param tail The write index.
+   * @return true if no element can be written at tail.
+   */
+  bool is_full(size_t head, size_t tail) const {
+    if constexpr (kPowerOfTwo) {
+      return tail - head == capacity_;
+    } else {
+      return next_index(tail) == head;
+    }
+  }
+
+  /**
+   * @brief Reloads the producer's cached copy of head_.
+   * @return The refreshed head index.
+   */
+  size_t refresh_head() {
+    cached_head_ = head_.load(std::memory_order_acquire);
+    return cached_head_;
+  }
+
+  /**
+   * @brief Reloads the consumer's cached copy of tail_.
+   * @return The refreshed tail index.
+   */
+  size_t refresh_tail() {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    return cached_tail_;
+  }
+
+  /**
+   * @brief Publishes a new tail_ to the consumer (producer).
+   * @param new_tail The tail index after the written elements.
+   */
+  void publish_tail(size_t new_tail) {
+    tail_.store(new_tail, std::memory_order_release);
+    if constexpr (kParking) {
+      wake_consumer();
+    }
+    if constexpr (Stats::kEnabled) {
+      stats_.pushed(
+          used_slots(head_.load(std::memory_order_relaxed), new_tail));
+    }
+  }
+
+  /**
+   * @brief Hands a new head_ back to the producer (consumer).
+   * @param new_head The head index after the consumed elements.
+   */
+  void publish_head(size_t new_head) {
+    head_.store(new_head, std::memory_order_release);
+    if constexpr (kParking) {
+      wake_producer();
+    }
+    stats_.popped();
+  }
+
+  /**
+   * @brief Waits for the consumer to make space, inside push() (producer).
+   */
+  void await_space() {
+    if constexpr (kParking) {
+      wait_for_space();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Waits for the producer to publish data, inside pop() (consumer).
+   */
+  void await_data() {
+    if constexpr (kParking) {
+      wait_for_data();
+    } else {
+      std::this_thread::yield();
+    }
   }
 
+  /**
+   * @brief Clears a parked flag and wakes the thread waiting on it, or calls
+   * the waker registered for that side, if any.
+   *
+   * The flag is the wait word, so clearing it wakes the waiter even when
+   * neither index changed.
+   * @param parked The parked flag of the side to wake.
+   * @param waker The registered waker of the side to wake.
+   */
+  void wake(std::atomic<bool>& parked,
+            std::atomic<const QueueWaker*>& waker) {
+    // Order the caller's preceding store before the flag loads (store-load
+    // barrier).
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed)) {
+      parked.store(false, std::memory_order_release);
+      parked.notify_one();
+    }
+    if (waker.load(std::memory_order_relaxed) != nullptr) {
+      // Counted before the waker is taken, so cancel_park() either takes it
+      // first or sees this call under way.
+      wakes_in_flight_.fetch_add(1);
+      if (const QueueWaker* taken = waker.exchange(nullptr)) {
+        taken->wake(taken->context);
+      }
+      wakes_in_flight_.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  /**
+   * @brief Withdraws a registered waker and waits until no wake() is calling
+   * one.
+   * @param waker The registered waker of one side.
+   */
+  void cancel_park(std::atomic<const QueueWaker*>& waker) {
+    waker.exchange(nullptr);
+    while (wakes_in_flight_.load(std::memory_order_acquire) != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Retries a non-blocking operation until it succeeds or the deadline
+   * passes.
+   *
+   * std::atomic::wait has no timed form, so timed operations poll with an
+   * exponential sleep backoff capped at kMaxTimedBackoff.
+   * @param deadline The point in time after which to give up.
+   * @param try_op The operation to retry, returning true on success.
+   * @return true if try_op succeeded, false on timeout.
+   */
+  template <typename Clock, typename Duration, typename TryOp>
+  static bool retry_until(
+      const std::chrono::time_point<Clock, Duration>& deadline,
+      TryOp&& try_op) {
+    std::chrono::microseconds backoff(1);
+    while (!try_op()) {
+      auto remaining = deadline - Clock::now();
+      if (remaining <= remaining.zero()) {
+        return false;
+      }
+      if (remaining < backoff) {
+        std::this_thread::sleep_for(remaining);
+      } else {
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, kMaxTimedBackoff);
+      }
+    }
+    return true;
+  }
+
+  // Upper bound on the sleep between retries of a timed operation.
+  static constexpr std::chrono::microseconds kMaxTimedBackoff{500};
+
+  // Uninitialised storage for one element.
+  struct Slot {
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+
+  // Size of the cache line used to keep producer and consumer state apart.
+  static constexpr size_t kCacheLineSize = 64;
+
+  // Read-only after construction and shared by both threads.
   const size_t capacity_;
-  std::atomic<size_t> head_ = 0;
-  std::atomic<size_t> tail_ = 0;
-  // The underlying buffer for storing elements.
-  // Allocated with capacity_ + 1 slots to distinguish full from empty.
-  std::unique_ptr<T[]> buffer_;
-};
\ No newline at end of file
+  // Index mask, only used in kPowerOfTwo mode.
+  const size_t mask_;
+  // The underlying buffer for storing elements. Slots only hold a live T
+  // between push and pop.
+  // Allocated with capacity_ + 1 slots in kModulo mode to distinguish full from
+  // empty, and with capacity_ slots in kPowerOfTwo mode.
+  std::unique_ptr<Slot[]> buffer_;
+  // Per slot: whether a slot outside [head_, tail_) still holds an element,
+  // left by release_read() or claimed but not yet committed. Owned by the
+  // producer while the slot is free and handed over with head_; only
+  // allocated when kRetains.
+  std::unique_ptr<bool[]> retained_;
+
+  // Consumer-owned state: the read index and the consumer's last observed
+  // value of tail_.
+  alignas(kCacheLineSize) std::atomic<size_t> head_ = 0;
+  size_t cached_tail_ = 0;
+
+  // Producer-owned state: the write index and the producer's last observed
+  // value of head_. The alignment also pads the end of the object so the
+  // producer line is not shared with whatever follows the queue in memory.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_ = 0;
+  size_t cached_head_ = 0;
+
+  // Parked flags for the blocking operations, also used as their wait words.
+  // Only written when a side parks, so the line stays shared in both caches
+  // on the non-blocking fast path. Unused with SPSCBlocking::kYield.
+  alignas(kCacheLineSize) std::atomic<bool> consumer_parked_ = false;
+  std::atomic<bool> producer_parked_ = false;
+  // Wakers registered by park_consumer()/park_producer(), and the number of
+  // wake() calls currently calling one.
+  std::atomic<const QueueWaker*> consumer_waker_ = nullptr;
+  std::atomic<const QueueWaker*> producer_waker_ = nullptr;
+  std::atomic<uint32_t> wakes_in_flight_ = 0;
+
+  // Instrumentation counters; takes no space with SPSCNoStats.
+  [[no_unique_address]] Stats stats_;
+};
+
+/**
+ * @brief BasicSPSCLockFreeQueue with the default policies: modulo indexing,
+ * no instrumentation and yielding blocking operations.
+ */
+template <typename T>
+using SPSCLockFreeQueue = BasicSPSCLockFreeQueue<T>;
+
+/**
+ * @brief SPSCLockFreeQueue in power-of-two mask-indexing mode, usable as a
+ * single-parameter queue template such as SpeechFilter's QueueType.
+ */
+template <typename T>
+using SPSCPow2Queue = BasicSPSCLockFreeQueue<T, SPSCIndexing::kPowerOfTwo>;
+
+/**
+ * @brief SPSCLockFreeQueue with SPSCQueueStats instrumentation, usable as a
+ * single-parameter queue template such as SpeechFilter's QueueType.
+ */
+template <typename T>
+using SPSCInstrumentedQueue =
+    BasicSPSCLockFreeQueue<T, SPSCIndexing::kModulo, SPSCQueueStats>;
+
+/**
+ * @brief SPSCLockFreeQueue whose blocking operations park instead of yield,
+ * for filters and threads that use WaitStrategy::kPark; usable as a
+ * single-parameter queue template such as SpeechFilter's QueueType.
+ */
+template <typename T>
+using SPSCParkingQueue =
+    BasicSPSCLockFreeQueue<T, SPSCIndexing::kModulo, SPSCNoStats,
+                           SPSCBlocking::kPark>;
@@ -0,0 +1,342 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief A Single-Producer, Single-Consumer (SPSC) lock-free queue living in
+ * a POSIX shared-memory segment, for passing data between processes.
+ *
+ * One process creates the named segment with a capacity and owns it (the name
+ * is unlinked when the creating handle is destroyed); the other process
+ * attaches to it by name. The segment starts with a versioned control block
+ * holding the head and tail counters on separate cache lines, followed by the
+ * element slots. Attaching validates the version and the element layout, so
+ * mismatched builds fail loudly instead of corrupting data.
+ *
+ * Elements are copied byte-wise between address spaces, so T must be
+ * trivially copyable (no pointers into process-private memory). Capacity is
+ * rounded up to a power of two and indices are free-running 64-bit counters,
+ * so 32-bit and 64-bit processes can share a queue.
+ *
+ * The queue exposes ValueType/try_push/try_pop and therefore plugs into
+ * SpeechFilter's QueueType parameter.
+ *
+ * @tparam T The trivially copyable element type.
+ */
+template <typename T>
+class SPSCSharedMemoryQueue {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "SPSCSharedMemoryQueue elements must be trivially copyable.");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "SPSCSharedMemoryQueue needs address-free 64-bit atomics.");
+
+ public:
+  using ValueType = T;
+
+  // Bumped whenever the shared layout changes.
+  static constexpr uint32_t kVersion = 1;
+
+  /**
+   * @brief Creates a new named shared-memory queue.
+   * @param name The POSIX shared-memory object name, e.g. "/capture0".
+   * @param capacity The maximum number of elements, rounded up to a power of
+   * two.
+   * @throws std::runtime_error If capacity is zero or the segment cannot be
+   * created (including when the name already exists).
+   */
+  SPSCSharedMemoryQueue(const std::string& name, size_t capacity)
+      : name_(name), owner_(true) {
+    if (capacity == 0) {
+      throw std::runtime_error(
+          "SPSCSharedMemoryQueue capacity cannot be zero.");
+    }
+    if (capacity > (SIZE_MAX >> 1) + 1) {
+      throw std::runtime_error("SPSCSharedMemoryQueue capacity too large.");
+    }
+    capacity_ = std::bit_ceil(capacity);
+    if (!segment_size(capacity_, mapped_size_)) {
+      throw std::runtime_error("SPSCSharedMemoryQueue capacity too large.");
+    }
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      throw_errno("create");
+    }
+    if (ftruncate(fd, static_cast<off_t>(mapped_size_)) != 0) {
+      int err = errno;
+      close(fd);
+      shm_unlink(name.c_str());
+      errno = err;
+      throw_errno("size");
+    }
+    map(fd);
+
+    control_ = new (mapping_) ControlBlock{};
+    control_->element_size = sizeof(T);
+    control_->element_align = alignof(T);
+    control_->capacity = capacity_;
+    control_->magic = kMagic;
+    // Publish the initialised block to attaching processes.
+    control_->version.store(kVersion, std::memory_order_release);
+    buffer_ = reinterpret_cast<T*>(static_cast<std::byte*>(mapping_) +
+                                   buffer_offset());
+  }
+
+  /**
+   * @brief Attaches to an existing named shared-memory queue.
+   * @param name The POSIX shared-memory object name used by the creator.
+   * @throws std::runtime_error If the segment does not exist, is not
+   * initialised yet, was created with a different version or element layout,
+   * or its header holds a capacity that does not fit the segment.
+   */
+  explicit SPSCSharedMemoryQueue(const std::string& name)
+      : name_(name), owner_(false) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+      throw_errno("attach");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < buffer_offset()) {
+      close(fd);
+      throw std::runtime_error("SPSCSharedMemoryQueue '" + name +
+                               "' is not initialised.");
+    }
+    mapped_size_ = static_cast<size_t>(st.st_size);
+    map(fd);
+
+    control_ = std::launder(reinterpret_cast<ControlBlock*>(mapping_));
+    uint32_t version = control_->version.load(std::memory_order_acquire);
+    // Read once: the header belongs to the peer and is only trusted after
+    // validation.
+    uint64_t capacity = control_->capacity;
+    size_t required_size = 0;
+    const char* error = nullptr;
+    if (version == 0) {
+      error = "is not initialised";
+    } else if (control_->magic != kMagic || version != kVersion) {
+      error = "has an incompatible version";
+    } else if (control_->element_size != sizeof(T) ||
+               control_->element_align != alignof(T)) {
+      error = "holds a different element type";
+    } else if (!segment_size(capacity, required_size)) {
+      error = "has an invalid capacity";
+    } else if (required_size > mapped_size_) {
+      error = "is truncated";
+    }
+    if (error) {
+      munmap(mapping_, mapped_size_);
+      throw std::runtime_error("SPSCSharedMemoryQueue '" + name + "' " +
+                               error + ".");
+    }
+    capacity_ = static_cast<size_t>(capacity);
+    buffer_ = reinterpret_cast<T*>(static_cast<std::byte*>(mapping_) +
+                                   buffer_offset());
+    // Start from the counters as they are now, in case the queue is in use.
+    cached_head_ = control_->head.load(std::memory_order_acquire);
+    cached_tail_ = control_->tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Unmaps the segment, and removes its name if this handle created it.
+   */
+  ~SPSCSharedMemoryQueue() {
+    munmap(mapping_, mapped_size_);
+    if (owner_) {
+      shm_unlink(name_.c_str());
+    }
+  }
+
+  SPSCSharedMemoryQueue(const SPSCSharedMemoryQueue&) = delete;
+  SPSCSharedMemoryQueue& operator=(const SPSCSharedMemoryQueue&) = delete;
+  SPSCSharedMemoryQueue(SPSCSharedMemoryQueue&&) = delete;
+  SPSCSharedMemoryQueue& operator=(SPSCSharedMemoryQueue&&) = delete;
+
+  /**
+   * @brief Attempts to push an element into the queue (non-blocking).
+   * @param value The element to copy into the queue.
+   * @return true if the element was successfully pushed, false if the queue is
+   * full.
+   */
+  bool try_push(const T& value) {
+    uint64_t current_tail = control_->tail.load(std::memory_order_relaxed);
+    if (current_tail - cached_head_ >= capacity_) {
+      cached_head_ = control_->head.load(std::memory_order_acquire);
+      if (current_tail - cached_head_ >= capacity_) {
+        return false;  // Queue is full
+      }
+    }
+
+    buffer_[slot(current_tail)] = value;
+    control_->tail.store(current_tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Attempts to pop an element from the queue (non-blocking).
+   * @param value A reference to store the popped element.
+   * @return true if an element was successfully popped, false if the queue is
+   * empty.
+   */
+  bool try_pop(T& value) {
+    uint64_t current_head = control_->head.load(std::memory_order_relaxed);
+    if (current_head == cached_tail_) {
+      cached_tail_ = control_->tail.load(std::memory_order_acquire);
+      if (current_head == cached_tail_) {
+        return false;  // Queue is empty
+      }
+    }
+
+    value = buffer_[slot(current_head)];
+    control_->head.store(current_head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Returns the approximate number of elements currently in the queue.
+   * @return The current size of the queue.
+   */
+  size_t size() const {
+    uint64_t current_head = control_->head.load(std::memory_order_acquire);
+    uint64_t current_tail = control_->tail.load(std::memory_order_acquire);
+    return static_cast<size_t>(
+        std::min<uint64_t>(current_tail - current_head, capacity_));
+  }
+
+  /**
+   * @brief Checks if the queue is empty.
+   * @return true if the queue contains no elements, false otherwise.
+   */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Checks if the queue is full.
+   * @return true if the queue has reached its maximum capacity, false
+   * otherwise.
+   */
+  bool full() const { return size() == capacity_; }
+
+  /**
+   * @brief Returns the maximum number of elements the queue can hold.
+   * @return The capacity, after power-of-two rounding.
+   */
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * @brief Returns the shared-memory object name.
+   * @return The name the queue was created or attached with.
+   */
+  const std::string& name() const { return name_; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+  // "SPSQ" in little-endian byte order.
+  static constexpr uint32_t kMagic = 0x51535053;
+
+  // Layout of the start of the shared segment. Only fixed-width fields, so the
+  // layout is identical for every process built against the same version.
+  struct ControlBlock {
+    // Zero until the creator has finished initialising the block.
+    std::atomic<uint32_t> version = 0;
+    uint32_t magic = 0;
+    uint64_t element_size = 0;
+    uint64_t element_align = 0;
+    uint64_t capacity = 0;
+    // Consumer-owned read counter.
+    alignas(kCacheLineSize) std::atomic<uint64_t> head = 0;
+    // Producer-owned write counter.
+    alignas(kCacheLineSize) std::atomic<uint64_t> tail = 0;
+  };
+
+  /**
+   * @brief Returns the offset of the element slots from the segment start.
+   * @return The control block size, rounded up to the slot alignment.
+   */
+  static constexpr size_t buffer_offset() {
+    constexpr size_t align = std::max(kCacheLineSize, alignof(T));
+    return (sizeof(ControlBlock) + align - 1) / align * align;
+  }
+
+  /**
+   * @brief Calculates the segment size needed for a capacity.
+   * @param capacity The element capacity, from the caller or a peer's header.
+   * @param size Set to the segment size in bytes if capacity is valid.
+   * @return false if capacity is zero or not a power of two, which the masked
+   * indexing relies on, or if the segment size overflows a size_t.
+   */
+  static bool segment_size(uint64_t capacity, size_t& size) {
+    if (!std::has_single_bit(capacity) ||
+        capacity > (SIZE_MAX - buffer_offset()) / sizeof(T)) {
+      return false;
+    }
+    size = buffer_offset() + static_cast<size_t>(capacity) * sizeof(T);
+    return true;
+  }
+
+  /**
+   * @brief Maps an index onto its buffer slot.
+   * @param index A free-running head or tail counter.
+   * @return The position of index in buffer_.
+   */
+  size_t slot(uint64_t index) const {
+    return static_cast<size_t>(index & (capacity_ - 1));
+  }
+
+  /**
+   * @brief Maps the whole segment and closes its descriptor.
+   * @param fd The open shared-memory descriptor.
+   * @throws std::runtime_error If mapping fails; the name is unlinked when
+   * this handle owns it.
+   */
+  void map(int fd) {
+    void* addr =
+        mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+      if (owner_) {
+        shm_unlink(name_.c_str());
+      }
+      errno = err;
+      throw_errno("map");
+    }
+    mapping_ = addr;
+  }
+
+  /**
+   * @brief Throws a std::runtime_error describing the current errno.
+   * @param what The operation that failed.
+   */
+  [[noreturn]] void throw_errno(const char* what) const {
+    throw std::runtime_error("SPSCSharedMemoryQueue failed to " +
+                             std::string(what) + " '" + name_ +
+                             "': " + std::strerror(errno));
+  }
+
+  std::string name_;
+  bool owner_;
+  size_t capacity_ = 0;
+  size_t mapped_size_ = 0;
+  void* mapping_ = nullptr;
+  ControlBlock* control_ = nullptr;
+  T* buffer_ = nullptr;
+
+  // Process-local copies of the opposite counter, on separate cache lines in
+  // case one handle is shared by a producer and a consumer thread.
+  alignas(kCacheLineSize) uint64_t cached_head_ = 0;
+  alignas(kCacheLineSize) uint64_t cached_tail_ = 0;
+};
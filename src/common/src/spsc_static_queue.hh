@@ -0,0 +1,201 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief A Single-Producer, Single-Consumer (SPSC) lock-free queue with a
+ * compile-time capacity and inline storage.
+ *
+ * Behaves like SPSCLockFreeQueue, but stores its slots in an array member
+ * instead of a heap allocation. The capacity is a constant expression, so the
+ * wrap-around folds at compile time and element access needs no pointer
+ * indirection. Suited to embedded targets without a heap and to large numbers
+ * of small per-stream queues.
+ *
+ * As in SPSCLockFreeQueue, slots are raw aligned storage: an element is
+ * constructed in place when it is pushed and destroyed when it is popped, so
+ * empty slots hold no resources and T need not be default constructible.
+ *
+ * To use it as SpeechFilter's QueueType, bind the capacity with an alias:
+ * `template <typename T> using FrameQueue = SPSCStaticQueue<T, 16>;`
+ *
+ * @tparam T The type of elements to store in the queue. T must be movable or
+ * copyable; try_pop() additionally needs it to be move assignable.
+ * @tparam N The maximum number of elements the queue can hold.
+ */
+template <typename T, size_t N>
+class SPSCStaticQueue {
+  static_assert(N > 0, "SPSCStaticQueue capacity cannot be zero.");
+
+ public:
+  using ValueType = T;
+
+  SPSCStaticQueue() = default;
+
+  /**
+   * @brief Destroys the queue and any elements still stored in it.
+   */
+  ~SPSCStaticQueue() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      size_t current_tail = tail_.load(std::memory_order_relaxed);
+      for (size_t i = head_.load(std::memory_order_relaxed); i != current_tail;
+           i = next_index(i)) {
+        std::destroy_at(element(i));
+      }
+    }
+  }
+
+  // Copying or moving would tear the atomic state shared with the other
+  // thread, so the queue is pinned in place like SPSCLockFreeQueue.
+  SPSCStaticQueue(const SPSCStaticQueue&) = delete;
+  SPSCStaticQueue& operator=(const SPSCStaticQueue&) = delete;
+  SPSCStaticQueue(SPSCStaticQueue&&) = delete;
+  SPSCStaticQueue& operator=(SPSCStaticQueue&&) = delete;
+
+  /**
+   * @brief Attempts to push an element into the queue (non-blocking, copy).
+   * @param value The element to copy into the queue.
+   * @return true if the element was successfully pushed, false if the queue is
+   * full.
+   */
+  bool try_push(const T& value) { return emplace_back(value); }
+
+  /**
+   * @brief Attempts to push an element into the queue (non-blocking, move).
+   * @param value The element to move into the queue.
+   * @return true if the element was successfully pushed, false if the queue is
+   * full.
+   */
+  bool try_push(T&& value) { return emplace_back(std::move(value)); }
+
+  /**
+   * @brief Attempts to pop an element from the queue (non-blocking).
+   * @param value A reference to store the popped element.
+   * @return true if an element was successfully popped, false if the queue is
+   * empty.
+   */
+  bool try_pop(T& value) {
+    size_t current_head = head_.load(std::memory_order_relaxed);
+    // Only refresh the cached tail when it says the queue is empty.
+    if (current_head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (current_head == cached_tail_) {
+        return false;  // Queue is empty
+      }
+    }
+
+    T* front = element(current_head);
+    value = std::move(*front);  // Move element out
+    std::destroy_at(front);
+    head_.store(next_index(current_head), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Returns the approximate number of elements currently in the queue.
+   * @return The current size of the queue.
+   */
+  size_t size() const {
+    size_t current_head = head_.load(std::memory_order_relaxed);
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    return current_tail >= current_head ? current_tail - current_head
+                                        : kSlots + current_tail - current_head;
+  }
+
+  /**
+   * @brief Checks if the queue is empty.
+   * @return true if the queue contains no elements, false otherwise.
+   */
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Checks if the queue is full.
+   * @return true if the queue has reached its maximum capacity, false
+   * otherwise.
+   */
+  bool full() const {
+    return next_index(tail_.load(std::memory_order_acquire)) ==
+           head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Returns the maximum number of elements the queue can hold.
+   * @return N.
+   */
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  // One slot is kept empty to distinguish full from empty.
+  static constexpr size_t kSlots = N + 1;
+  static constexpr size_t kCacheLineSize = 64;
+
+  /**
+   * @brief Calculates the next index in the circular buffer.
+   * @param current_index The current index.
+   * @return The next index, wrapping around if necessary.
+   */
+  static constexpr size_t next_index(size_t current_index) {
+    return (current_index + 1) % kSlots;
+  }
+
+  /**
+   * @brief Returns the raw storage of a slot, to construct an element in.
+   * @param index The slot index.
+   * @return A pointer to the slot's uninitialised storage.
+   */
+  T* storage(size_t index) {
+    return reinterpret_cast<T*>(buffer_[index].storage);
+  }
+
+  /**
+   * @brief Returns the live element in a slot.
+   * @param index A slot index holding a constructed element.
+   * @return A pointer to the element.
+   */
+  T* element(size_t index) { return std::launder(storage(index)); }
+
+  /**
+   * @brief Writes an element at the tail if there is space.
+   * @param value The element to copy or move into the queue.
+   * @return true if the element was written, false if the queue is full.
+   */
+  template <typename U>
+  bool emplace_back(U&& value) {
+    size_t current_tail = tail_.load(std::memory_order_relaxed);
+    size_t next_tail = next_index(current_tail);
+    // Only refresh the cached head when it says the queue is full.
+    if (next_tail == cached_head_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (next_tail == cached_head_) {
+        return false;  // Queue is full
+      }
+    }
+
+    std::construct_at(storage(current_tail), std::forward<U>(value));
+    tail_.store(next_tail, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer-owned state.
+  alignas(kCacheLineSize) std::atomic<size_t> head_ = 0;
+  size_t cached_tail_ = 0;
+
+  // Producer-owned state.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_ = 0;
+  size_t cached_head_ = 0;
+
+  // Uninitialised storage for one element.
+  struct Slot {
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+
+  // Inline element storage, on its own cache line(s).
+  alignas(kCacheLineSize) Slot buffer_[kSlots];
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cerrno>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+namespace SpeechTools {
+
+// Scheduling policy of a filter thread.
+enum class SchedPolicy {
+  kDefault,     // Leave the thread with the OS default (SCHED_OTHER).
+  kFifo,        // SCHED_FIFO real-time scheduling.
+  kRoundRobin,  // SCHED_RR real-time scheduling.
+};
+
+/**
+ * @brief OS-level settings for a filter thread, applied before it processes
+ * its first frame. Default-constructed options change nothing.
+ */
+struct ThreadOptions {
+  // Cores the thread may run on; empty leaves the affinity unchanged.
+  std::vector<int> cpus;
+  SchedPolicy policy = SchedPolicy::kDefault;
+  // Real-time priority, used with kFifo and kRoundRobin (1-99 on Linux).
+  int priority = 0;
+  // Thread name shown by top/perf; Linux keeps the first 15 characters.
+  std::string name;
+  // Locks all current and future pages of the process into RAM (mlockall),
+  // so the thread never takes a page fault. This affects the whole process.
+  bool lock_memory = false;
+};
+
+/**
+ * @brief The outcome of applying ThreadOptions: one errno value per setting,
+ * 0 if it was applied or not requested. Settings the platform does not
+ * support report ENOTSUP; a real-time policy without CAP_SYS_NICE reports
+ * EPERM.
+ */
+struct ThreadOptionsStatus {
+  int affinity = 0;
+  int scheduling = 0;
+  int name = 0;
+  int memory_lock = 0;
+
+  /**
+   * @brief Checks whether every requested setting was applied.
+   * @return true if no setting failed.
+   */
+  bool ok() const {
+    return affinity == 0 && scheduling == 0 && name == 0 && memory_lock == 0;
+  }
+};
+
+/**
+ * @brief Applies options to a thread.
+ * @param thread The thread to configure; it must be running.
+ * @param options The settings to apply.
+ * @return The outcome of each setting. Settings are independent: one failing
+ * does not stop the others from being applied.
+ */
+inline ThreadOptionsStatus applyThreadOptions(std::thread& thread,
+                                              const ThreadOptions& options) {
+  ThreadOptionsStatus status;
+#ifdef __linux__
+  pthread_t handle = thread.native_handle();
+  if (!options.cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : options.cpus) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        status.affinity = EINVAL;
+        break;
+      }
+      CPU_SET(cpu, &set);
+    }
+    if (status.affinity == 0) {
+      status.affinity = pthread_setaffinity_np(handle, sizeof(set), &set);
+    }
+  }
+  if (options.policy != SchedPolicy::kDefault) {
+    sched_param param{};
+    param.sched_priority = options.priority;
+    int policy = options.policy == SchedPolicy::kFifo ? SCHED_FIFO : SCHED_RR;
+    status.scheduling = pthread_setschedparam(handle, policy, &param);
+  }
+  if (!options.name.empty()) {
+    status.name =
+        pthread_setname_np(handle, options.name.substr(0, 15).c_str());
+  }
+  if (options.lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    status.memory_lock = errno;
+  }
+#else
+  (void)thread;
+  if (!options.cpus.empty()) {
+    status.affinity = ENOTSUP;
+  }
+  if (options.policy != SchedPolicy::kDefault) {
+    status.scheduling = ENOTSUP;
+  }
+  if (!options.name.empty()) {
+    status.name = ENOTSUP;
+  }
+  if (options.lock_memory) {
+    status.memory_lock = ENOTSUP;
+  }
+#endif
+  return status;
+}
+
+}  // namespace SpeechTools
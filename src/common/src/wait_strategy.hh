@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace SpeechTools {
+
+/**
+ * @brief How a filter thread waits while its input queue is empty or its
+ * output queue is full.
+ */
+enum class WaitStrategy {
+  // Spin with a CPU pause hint. Lowest wake-up latency, but keeps a core busy.
+  kBusySpin,
+  // Spin briefly, then yield the time slice on every retry. The pre-existing
+  // behaviour; still shows as a fully used core while idle.
+  kYield,
+  // Spin briefly, yield a few times, then park the thread until the queue
+  // wakes it. Uses no CPU while idle at the cost of a futex wake-up.
+  kPark,
+};
+
+/**
+ * @brief Hints to the CPU that the caller is in a spin-wait loop.
+ */
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief Escalating backoff for one wait, following a WaitStrategy.
+ *
+ * Call pause() on every failed attempt and reset() after progress. pause()
+ * returns true once the strategy says the caller should park.
+ */
+class IdleBackoff {
+ public:
+  explicit IdleBackoff(WaitStrategy strategy) : strategy_(strategy) {}
+
+  /**
+   * @brief Waits a little before the next attempt.
+   * @return true if the caller should now park instead of retrying.
+   */
+  bool pause() {
+    if (strategy_ == WaitStrategy::kBusySpin) {
+      cpuRelax();
+      return false;
+    }
+    if (attempts_ < kSpinLimit) {
+      ++attempts_;
+      cpuRelax();
+      return false;
+    }
+    if (strategy_ == WaitStrategy::kYield || attempts_ < kYieldLimit) {
+      attempts_ += attempts_ < kYieldLimit;
+      std::this_thread::yield();
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Starts over with spinning, after the caller made progress.
+   */
+  void reset() { attempts_ = 0; }
+
+ private:
+  // Attempts spent spinning, then spent yielding, before parking.
+  static constexpr uint32_t kSpinLimit = 64;
+  static constexpr uint32_t kYieldLimit = kSpinLimit + 16;
+
+  WaitStrategy strategy_;
+  uint32_t attempts_ = 0;
+};
+
+}  // namespace SpeechTools
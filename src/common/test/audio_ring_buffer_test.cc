@@ -0,0 +1,264 @@
+#include "../src/audio_ring_buffer.hh"
+
+#include <gtest/gtest.h>
+
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+#include "../src/spsc_queue.hh"
+
+using Frame = std::vector<std::vector<float>>;
+
+// Writes frames [first, first + frames) as sample value frame * 10 + channel.
+template <typename Ring>
+bool writeRamp(Ring& ring, size_t first, size_t frames, size_t channels) {
+  auto block = ring.prepare_write(frames);
+  if (block.empty()) {
+    return false;
+  }
+  for (size_t i = 0; i < frames; ++i) {
+    for (size_t c = 0; c < channels; ++c) {
+      float v = static_cast<float>((first + i) * 10 + c);
+      if constexpr (requires { block.channel(c); }) {
+        block.channel(c)[i] = v;
+      } else {
+        block.samples()[i * channels + c] = v;
+      }
+    }
+  }
+  ring.commit_write(frames);
+  return true;
+}
+
+// Write and read spans in the planar layout
+TEST(AudioRingBufferTest, PlanarWriteRead) {
+  AudioRingBuffer<float, 2> ring(16, 4);
+  EXPECT_TRUE(ring.empty());
+  EXPECT_TRUE(writeRamp(ring, 0, 3, 2));
+  EXPECT_EQ(ring.size(), 3u);
+  EXPECT_TRUE(ring.peek(4).empty());
+  auto block = ring.peek(3);
+  ASSERT_EQ(block.frames(), 3u);
+  EXPECT_EQ(block.channel(0)[2], 20.0f);
+  EXPECT_EQ(block.channel(1)[0], 1.0f);
+  ring.consume(3);
+  EXPECT_TRUE(ring.empty());
+}
+
+// Write and read spans in the interleaved layout
+TEST(AudioRingBufferTest, InterleavedWriteRead) {
+  AudioRingBuffer<float, 2, AudioLayout::kInterleaved> ring(16, 4);
+  EXPECT_TRUE(writeRamp(ring, 0, 4, 2));
+  auto block = ring.peek(4);
+  ASSERT_EQ(block.frames(), 4u);
+  std::span<const float> samples = block.samples();
+  ASSERT_EQ(samples.size(), 8u);
+  EXPECT_EQ(samples[0], 0.0f);
+  EXPECT_EQ(samples[1], 1.0f);
+  EXPECT_EQ(samples[6], 30.0f);
+  EXPECT_EQ(samples[7], 31.0f);
+}
+
+// Blocks stay contiguous across the wrap, with overlapping windows read in
+// place and consumed by a smaller hop
+template <AudioLayout Layout>
+void checkWindowedStream() {
+  constexpr size_t kChannels = 3;
+  AudioRingBuffer<float, kChannels, Layout> ring(10, 7);
+  const size_t writes[] = {7, 3, 5, 1, 6, 2};
+  const size_t window = 6;
+  const size_t hop = 4;
+  size_t written = 0;
+  size_t read = 0;
+  for (int step = 0; step < 200; ++step) {
+    size_t n = writes[step % 6];
+    if (writeRamp(ring, written, n, kChannels)) {
+      written += n;
+    }
+    auto block = ring.peek(window);
+    if (block.empty()) {
+      continue;
+    }
+    for (size_t i = 0; i < window; ++i) {
+      for (size_t c = 0; c < kChannels; ++c) {
+        float expected = static_cast<float>((read + i) * 10 + c);
+        if constexpr (Layout == AudioLayout::kPlanar) {
+          ASSERT_EQ(block.channel(c)[i], expected);
+        } else {
+          ASSERT_EQ(block.samples()[i * kChannels + c], expected);
+        }
+      }
+    }
+    ring.consume(hop);
+    read += hop;
+  }
+  EXPECT_GT(read, 100u);
+}
+
+TEST(AudioRingBufferTest, PlanarWrapWindows) {
+  checkWindowedStream<AudioLayout::kPlanar>();
+}
+
+TEST(AudioRingBufferTest, InterleavedWrapWindows) {
+  checkWindowedStream<AudioLayout::kInterleaved>();
+}
+
+// Full ring and oversized blocks are rejected
+TEST(AudioRingBufferTest, CapacityLimits) {
+  AudioRingBuffer<float, 1> ring(8, 4);
+  EXPECT_TRUE(ring.prepare_write(5).empty());
+  EXPECT_TRUE(writeRamp(ring, 0, 4, 1));
+  EXPECT_TRUE(writeRamp(ring, 4, 4, 1));
+  EXPECT_TRUE(ring.full());
+  EXPECT_TRUE(ring.prepare_write(1).empty());
+  ring.consume(1);
+  EXPECT_FALSE(ring.prepare_write(1).empty());
+  EXPECT_THROW((AudioRingBuffer<float, 1>(4, 5)), std::runtime_error);
+  EXPECT_THROW((AudioRingBuffer<float, 1>(0, 0)), std::runtime_error);
+}
+
+// Frame-block queue interface used by SpeechFilter
+TEST(AudioRingBufferTest, FrameQueueInterface) {
+  AudioRingBuffer<float, 2, AudioLayout::kInterleaved> ring(8, 3);
+  EXPECT_TRUE(ring.try_push(Frame{{1, 2}, {3, 4}}));
+  Frame out;
+  EXPECT_FALSE(ring.try_pop(out));
+  EXPECT_TRUE(ring.try_push(Frame{{5}, {6}}));
+  EXPECT_TRUE(ring.try_pop(out));
+  EXPECT_EQ(out, (Frame{{1, 2, 5}, {3, 4, 6}}));
+  // Malformed blocks are rejected without throwing.
+  EXPECT_FALSE(ring.accepts(Frame{{1}}));
+  EXPECT_FALSE(ring.try_push(Frame{{1}}));
+  EXPECT_FALSE(ring.try_push(Frame{{1, 2, 3, 4}, {1, 2, 3, 4}}));
+  EXPECT_FALSE(ring.try_push(Frame{{1, 2}, {3}}));
+  EXPECT_TRUE(ring.accepts(Frame{{1, 2}, {3, 4}}));
+  EXPECT_TRUE(ring.empty());
+}
+
+// Producer and consumer on separate threads with different block sizes
+TEST(AudioRingBufferTest, SPSCConcurrent) {
+  AudioRingBuffer<float, 2> ring(64, 16);
+  constexpr size_t kFrames = 20000;
+  std::thread producer([&]() {
+    for (size_t written = 0; written < kFrames;) {
+      size_t n = std::min<size_t>(1 + written % 13, kFrames - written);
+      if (writeRamp(ring, written, n, 2)) {
+        written += n;
+      }
+    }
+  });
+  size_t errors = 0;
+  std::thread consumer([&]() {
+    for (size_t read = 0; read < kFrames;) {
+      size_t n = std::min<size_t>(1 + read % 16, kFrames - read);
+      auto block = ring.peek(n);
+      if (block.empty()) {
+        continue;
+      }
+      for (size_t i = 0; i < n; ++i) {
+        float expected = static_cast<float>((read + i) * 10);
+        errors += block.channel(0)[i] != expected;
+        errors += block.channel(1)[i] != expected + 1;
+      }
+      ring.consume(n);
+      read += n;
+    }
+  });
+  producer.join();
+  consumer.join();
+  EXPECT_EQ(errors, 0u);
+}
+
+// The ring plugs into SpeechFilter as its frame queue
+template <typename>
+using StereoRing = AudioRingBuffer<float, 2>;
+
+class GainFilter : public SpeechTools::SpeechFilter<Frame, Frame, StereoRing> {
+ public:
+  GainFilter(StereoRing<Frame>& in, StereoRing<Frame>& out)
+      : SpeechTools::SpeechFilter<Frame, Frame, StereoRing>(in, out) {}
+
+ protected:
+  Frame process(const Frame& input_data) override {
+    Frame out = input_data;
+    for (auto& channel : out) {
+      for (float& sample : channel) {
+        sample *= 2;
+      }
+    }
+    return out;
+  }
+};
+
+TEST(AudioRingBufferTest, PlugsIntoSpeechFilter) {
+  static_assert(SpeechTools::QueueWithValueType<StereoRing<Frame>, Frame>);
+  StereoRing<Frame> in(16, 2), out(16, 2);
+  GainFilter filter(in, out);
+  EXPECT_TRUE(in.try_push(Frame{{1, 2}, {3, 4}}));
+  Frame result;
+  while (!out.try_pop(result)) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(result, (Frame{{2, 4}, {6, 8}}));
+}
+
+// A SpeechFilter reads overlapping windows in place through an
+// AudioWindowReader
+using MonoRing = AudioRingBuffer<float, 1>;
+using MonoWindow = MonoRing::ReadBlock;
+
+class WindowSumFilter
+    : public SpeechTools::SpeechFilter<MonoWindow, float, SPSCLockFreeQueue,
+                                       SpeechTools::FilterNoTelemetry,
+                                       AudioWindowReader> {
+ public:
+  WindowSumFilter(AudioWindowReader<MonoWindow>& in,
+                  SPSCLockFreeQueue<float>& out, size_t max_batch = 1)
+      : SpeechTools::SpeechFilter<MonoWindow, float, SPSCLockFreeQueue,
+                                  SpeechTools::FilterNoTelemetry,
+                                  AudioWindowReader>(
+            in, out, SpeechTools::WaitStrategy::kYield, max_batch) {}
+
+  // Ring samples the last window started at
+  const float* last_window = nullptr;
+
+ protected:
+  float process(const MonoWindow& input_data) override {
+    std::span<const float> samples = input_data.channel(0);
+    last_window = samples.data();
+    float sum = 0;
+    for (float sample : samples) {
+      sum += sample;
+    }
+    return sum;
+  }
+};
+
+TEST(AudioRingBufferTest, WindowReaderFeedsSpeechFilterInPlace) {
+  static_assert(SpeechTools::PeekQueue<AudioWindowReader<MonoWindow>>);
+  MonoRing ring(16, 4);
+  AudioWindowReader<MonoWindow> reader(ring, 4, 2);
+  SPSCLockFreeQueue<float> out(8);
+  EXPECT_THROW(WindowSumFilter(reader, out, 2), std::runtime_error);
+
+  // Frames 0..9 hold 0, 10, ..., 90: windows [0, 4), [2, 6), [4, 8), [6, 10).
+  ASSERT_TRUE(writeRamp(ring, 0, 4, 1));
+  ASSERT_TRUE(writeRamp(ring, 4, 4, 1));
+  ASSERT_TRUE(writeRamp(ring, 8, 2, 1));
+  WindowSumFilter filter(reader, out);
+  for (float expected : {60.0f, 140.0f, 220.0f, 300.0f}) {
+    float sum;
+    while (!out.try_pop(sum)) {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ(sum, expected);
+  }
+  filter.halt();
+  // The last window, frames [6, 10), was read from the ring's storage, not a
+  // copy; frames 8 and 9 are still buffered.
+  EXPECT_EQ(ring.size(), 2u);
+  EXPECT_EQ(filter.last_window + 2, ring.peek(2).channel(0).data());
+}
@@ -0,0 +1,317 @@
+#include "../src/broadcast_ring.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+#include "../src/spsc_queue.hh"
+
+// Every reader sees every element, independently of the others
+TEST(SPMCBroadcastRingTest, EveryReaderSeesEveryElement) {
+  SPMCBroadcastRing<int> ring(4, 3);
+  EXPECT_EQ(ring.reader_count(), 3u);
+  EXPECT_TRUE(ring.try_push(1));
+  EXPECT_TRUE(ring.try_push(2));
+  int v;
+  for (size_t r = 0; r < ring.reader_count(); ++r) {
+    auto& reader = ring.reader(r);
+    EXPECT_EQ(reader.size(), 2u);
+    EXPECT_TRUE(reader.try_pop(v));
+    EXPECT_EQ(v, 1);
+    EXPECT_TRUE(reader.try_pop(v));
+    EXPECT_EQ(v, 2);
+    EXPECT_FALSE(reader.try_pop(v));
+    EXPECT_TRUE(reader.empty());
+  }
+  EXPECT_THROW(ring.reader(3), std::out_of_range);
+}
+
+// The slowest reader gates the writer
+TEST(SPMCBroadcastRingTest, SlowestReaderBlocksWriter) {
+  SPMCBroadcastRing<int> ring(3, 2);
+  EXPECT_EQ(ring.capacity(), 4u);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(ring.try_push(i));
+  }
+  int v;
+  // Reader 0 drains, reader 1 has not read anything yet.
+  while (ring.reader(0).try_pop(v)) {
+  }
+  EXPECT_FALSE(ring.try_push(4));
+  EXPECT_TRUE(ring.reader(1).try_pop(v));
+  EXPECT_EQ(v, 0);
+  EXPECT_TRUE(ring.try_push(4));
+  EXPECT_FALSE(ring.try_push(5));
+  EXPECT_EQ(ring.reader(1).dropped(), 0u);
+}
+
+// Under kOverwriteLaggard the writer never fails and laggards skip ahead
+TEST(SPMCBroadcastRingTest, OverwriteLaggard) {
+  SPMCBroadcastRing<int, BroadcastPolicy::kOverwriteLaggard> ring(4, 2);
+  int v;
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(ring.try_push(i));
+    EXPECT_TRUE(ring.reader(0).try_pop(v));
+    EXPECT_EQ(v, i);
+  }
+  auto& laggard = ring.reader(1);
+  EXPECT_EQ(laggard.dropped(), 6u);
+  EXPECT_EQ(laggard.size(), 4u);
+  for (int i = 6; i < 10; ++i) {
+    EXPECT_TRUE(laggard.try_pop(v));
+    EXPECT_EQ(v, i);
+  }
+  EXPECT_FALSE(laggard.try_pop(v));
+  EXPECT_EQ(ring.reader(0).dropped(), 0u);
+}
+
+// A writer that finds a reader reading the oldest slot drops the new element
+// instead of waiting for the read to finish
+TEST(SPMCBroadcastRingTest, OverwriteDropsIncomingWhileSlotBusy) {
+  SPMCBroadcastRing<int, BroadcastPolicy::kOverwriteLaggard> ring(2, 2);
+  EXPECT_TRUE(ring.try_push(0));
+  EXPECT_TRUE(ring.try_push(1));
+  const int* front = ring.reader(0).peek();
+  ASSERT_NE(front, nullptr);
+  EXPECT_TRUE(ring.try_push(2));
+  EXPECT_EQ(*front, 0);
+  ring.reader(0).release();
+  for (size_t r = 0; r < 2; ++r) {
+    EXPECT_EQ(ring.reader(r).dropped(), 1u);
+  }
+
+  int v;
+  EXPECT_TRUE(ring.reader(0).try_pop(v));
+  EXPECT_EQ(v, 1);
+  EXPECT_FALSE(ring.reader(0).try_pop(v));
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(ring.reader(1).try_pop(v));
+    EXPECT_EQ(v, i);
+  }
+  // Once nobody reads the oldest slot, pushes overwrite it again.
+  EXPECT_TRUE(ring.try_push(3));
+  EXPECT_TRUE(ring.reader(0).try_pop(v));
+  EXPECT_EQ(v, 3);
+}
+
+// peek/release reads in place without copying
+TEST(SPMCBroadcastRingTest, PeekRelease) {
+  SPMCBroadcastRing<std::string> ring(2, 2);
+  EXPECT_EQ(ring.reader(0).peek(), nullptr);
+  EXPECT_TRUE(ring.try_push(std::string("frame")));
+  for (size_t r = 0; r < 2; ++r) {
+    const std::string* front = ring.reader(r).peek();
+    ASSERT_NE(front, nullptr);
+    EXPECT_EQ(*front, "frame");
+    ring.reader(r).release();
+    EXPECT_EQ(ring.reader(r).peek(), nullptr);
+  }
+}
+
+TEST(SPMCBroadcastRingTest, ZeroCapacityOrReaders) {
+  EXPECT_THROW((SPMCBroadcastRing<int>(0, 1)), std::runtime_error);
+  EXPECT_THROW((SPMCBroadcastRing<int>(4, 0)), std::runtime_error);
+}
+
+// One writer, several concurrent readers: each reader sees the full sequence
+TEST(SPMCBroadcastRingTest, ConcurrentReaders) {
+  constexpr int kReaders = 3;
+  constexpr int kCount = 2000;
+  SPMCBroadcastRing<int> ring(16, kReaders);
+  std::vector<std::vector<int>> results(kReaders);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < kReaders; ++r) {
+    readers.emplace_back([&, r]() {
+      int v;
+      for (int i = 0; i < kCount; ++i) {
+        while (!ring.reader(r).try_pop(v)) {
+          std::this_thread::yield();
+        }
+        results[r].push_back(v);
+      }
+    });
+  }
+  for (int i = 0; i < kCount; ++i) {
+    while (!ring.try_push(i)) {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& t : readers) {
+    t.join();
+  }
+  for (int r = 0; r < kReaders; ++r) {
+    ASSERT_EQ(results[r].size(), static_cast<size_t>(kCount));
+    for (int i = 0; i < kCount; ++i) {
+      EXPECT_EQ(results[r][i], i);
+    }
+  }
+}
+
+// Overwrite policy under concurrency: readers see an increasing sequence and
+// account for every element they skipped
+TEST(SPMCBroadcastRingTest, OverwriteConcurrent) {
+  constexpr int kCount = 5000;
+  SPMCBroadcastRing<int, BroadcastPolicy::kOverwriteLaggard> ring(8, 2);
+  std::atomic<bool> done = false;
+  std::vector<uint64_t> seen(2, 0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; ++r) {
+    readers.emplace_back([&, r]() {
+      auto& reader = ring.reader(r);
+      int v;
+      int last = -1;
+      for (;;) {
+        bool finished = done.load();
+        if (reader.try_pop(v)) {
+          EXPECT_GT(v, last);
+          last = v;
+          ++seen[r];
+        } else if (finished) {
+          break;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+      EXPECT_EQ(last, kCount - 1);
+    });
+  }
+  for (int i = 0; i < kCount; ++i) {
+    EXPECT_TRUE(ring.try_push(i));
+  }
+  done.store(true);
+  for (auto& t : readers) {
+    t.join();
+  }
+  for (int r = 0; r < 2; ++r) {
+    EXPECT_EQ(seen[r] + ring.reader(r).dropped(),
+              static_cast<uint64_t>(kCount));
+  }
+}
+
+// Filters reading from BroadcastReaders each process every element of the
+// ring, fanning one stream out to several filters
+template <int Factor, template <typename> class Reader = BroadcastReader>
+class ScaleFilter
+    : public SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue,
+                                       SpeechTools::FilterNoTelemetry, Reader> {
+ public:
+  ScaleFilter(Reader<int>& in, SPSCLockFreeQueue<int>& out)
+      : SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue,
+                                  SpeechTools::FilterNoTelemetry, Reader>(
+            in, out) {}
+
+ protected:
+  int process(const int& input_data) override { return input_data * Factor; }
+};
+
+TEST(SPMCBroadcastRingTest, FansOutToSpeechFilters) {
+  constexpr int kCount = 200;
+  SPMCBroadcastRing<int> ring(8, 2);
+  SPSCLockFreeQueue<int> doubled(8), tripled(8);
+  ScaleFilter<2> doubler(ring.reader(0), doubled);
+  ScaleFilter<3> tripler(ring.reader(1), tripled);
+  std::thread producer([&]() {
+    for (int i = 0; i < kCount; ++i) {
+      while (!ring.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (int i = 0; i < kCount; ++i) {
+    int v;
+    doubled.pop(v);
+    EXPECT_EQ(v, i * 2);
+    tripled.pop(v);
+    EXPECT_EQ(v, i * 3);
+  }
+  producer.join();
+}
+
+// A filter can take a branch of an overwriting ring; elements it was too slow
+// for are skipped, the rest arrive once and in order
+TEST(SPMCBroadcastRingTest, SpeechFilterReadsOverwritingRing) {
+  constexpr int kCount = 200;
+  SPMCBroadcastRing<int, BroadcastPolicy::kOverwriteLaggard> ring(8, 1);
+  SPSCLockFreeQueue<int> doubled(kCount);
+  ScaleFilter<2, LaggardBroadcastReader> doubler(ring.reader(0), doubled);
+  for (int i = 0; i < kCount; ++i) {
+    EXPECT_TRUE(ring.try_push(i));
+  }
+  while (doubled.size() + ring.reader(0).dropped() <
+         static_cast<uint64_t>(kCount)) {
+    std::this_thread::yield();
+  }
+  doubler.stop();
+  int last = -1;
+  int v;
+  while (doubled.try_pop(v)) {
+    EXPECT_EQ(v % 2, 0);
+    EXPECT_GT(v / 2, last);
+    last = v / 2;
+  }
+  EXPECT_GE(last, 0);
+}
+
+// A frame that counts how often it is copied
+struct CountedFrame {
+  static inline std::atomic<int> copies = 0;
+  int value = 0;
+
+  CountedFrame() = default;
+  explicit CountedFrame(int v) : value(v) {}
+  CountedFrame(const CountedFrame& other) : value(other.value) { ++copies; }
+  CountedFrame& operator=(const CountedFrame& other) {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+  CountedFrame(CountedFrame&&) = default;
+  CountedFrame& operator=(CountedFrame&&) = default;
+};
+
+class FrameValueFilter
+    : public SpeechTools::SpeechFilter<CountedFrame, int, SPSCLockFreeQueue,
+                                       SpeechTools::FilterNoTelemetry,
+                                       BroadcastReader> {
+ public:
+  FrameValueFilter(BroadcastReader<CountedFrame>& in,
+                   SPSCLockFreeQueue<int>& out)
+      : SpeechTools::SpeechFilter<CountedFrame, int, SPSCLockFreeQueue,
+                                  SpeechTools::FilterNoTelemetry,
+                                  BroadcastReader>(in, out) {}
+
+ protected:
+  int process(const CountedFrame& input_data) override {
+    return input_data.value;
+  }
+};
+
+// SpeechFilters read their branch in place: no frame is copied per reader
+TEST(SPMCBroadcastRingTest, SpeechFiltersReadInPlace) {
+  constexpr int kCount = 100;
+  CountedFrame::copies = 0;
+  SPMCBroadcastRing<CountedFrame> ring(8, 2);
+  SPSCLockFreeQueue<int> first(8), second(8);
+  FrameValueFilter a(ring.reader(0), first);
+  FrameValueFilter b(ring.reader(1), second);
+  std::thread producer([&]() {
+    for (int i = 0; i < kCount; ++i) {
+      while (!ring.try_push(CountedFrame(i))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (int i = 0; i < kCount; ++i) {
+    int v;
+    first.pop(v);
+    EXPECT_EQ(v, i);
+    second.pop(v);
+    EXPECT_EQ(v, i);
+  }
+  producer.join();
+  EXPECT_EQ(CountedFrame::copies, 0);
+}
@@ -0,0 +1,94 @@
+#include "../src/filter_chain.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+#include "../src/spsc_queue.hh"
+
+namespace {
+
+struct Scale {
+  using InType = int;
+  using OutType = double;
+  double factor;
+  double process(const int& input) { return input * factor; }
+};
+
+struct Offset {
+  using InType = double;
+  using OutType = double;
+  double offset;
+  int calls = 0;
+  double process(const double& input) {
+    ++calls;
+    return input + offset;
+  }
+};
+
+struct Format {
+  using InType = double;
+  using OutType = std::string;
+  std::string process(const double& input) {
+    return std::to_string(static_cast<int>(input));
+  }
+};
+
+}  // namespace
+
+// The stage types must line up at compile time
+TEST(FilterChainTest, StageTypeChecking) {
+  using SpeechTools::ChainableStages;
+  static_assert(ChainableStages<Scale, Offset, Format>);
+  static_assert(ChainableStages<Offset>);
+  static_assert(!ChainableStages<Scale, Scale>);
+  static_assert(!ChainableStages<Format, Offset>);
+  static_assert(!ChainableStages<>);
+  static_assert(!ChainableStages<int>);
+}
+
+// A fused chain behaves as one filter from int input to string output
+TEST(FilterChainTest, RunsStagesInOrder) {
+  SPSCParkingQueue<int> in(8);
+  SPSCParkingQueue<std::string> out(8);
+  SpeechTools::FilterChain<Scale, Offset, Format> chain(
+      in, out, Scale{2.0}, Offset{1.0}, Format{});
+  static_assert(std::same_as<decltype(chain)::InType, int>);
+  static_assert(std::same_as<decltype(chain)::OutType, std::string>);
+  for (int i = 0; i < 4; ++i) {
+    in.push(i);
+  }
+  for (int i = 0; i < 4; ++i) {
+    std::string v;
+    out.pop(v);
+    EXPECT_EQ(v, std::to_string(i * 2 + 1));
+  }
+  chain.stop();
+  EXPECT_EQ(chain.stage<1>().calls, 4);
+}
+
+// A single stage runs as a standalone filter
+TEST(FilterChainTest, SingleStage) {
+  SPSCParkingQueue<double> in(8), out(8);
+  SpeechTools::FilterChain<Offset> chain(in, out, Offset{2.0});
+  in.push(1.0);
+  double v;
+  out.pop(v);
+  EXPECT_DOUBLE_EQ(v, 3.0);
+  chain.stop();
+}
+
+// Chains can also run on a shared executor
+TEST(FilterChainTest, RunsOnExecutor) {
+  SpeechTools::FilterExecutor executor(1);
+  SPSCParkingQueue<double> in(8), out(8);
+  SpeechTools::FilterChain<Offset, Offset> chain(in, out, executor,
+                                                 Offset{1.0}, Offset{10.0});
+  chain.start();
+  in.push(0.5);
+  double v;
+  out.pop(v);
+  EXPECT_DOUBLE_EQ(v, 11.5);
+  chain.stop();
+}
@@ -0,0 +1,294 @@
+#include "../src/filter_executor.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+#include "../src/spsc_queue.hh"
+
+using IntQueue = SPSCLockFreeQueue<int>;
+
+template <template <typename> class Queue>
+class QueueAddFilter : public SpeechTools::SpeechFilter<int, int, Queue> {
+ public:
+  QueueAddFilter(Queue<int>& in, Queue<int>& out,
+                 SpeechTools::FilterExecutor& executor, size_t max_batch = 1)
+      : SpeechTools::SpeechFilter<int, int, Queue>(in, out, executor,
+                                                   max_batch) {}
+
+ protected:
+  int process(const int& input_data) override { return input_data + 1; }
+};
+
+using AddFilter = QueueAddFilter<SPSCLockFreeQueue>;
+
+// Adds to each input, slowly, and reports when a worker first entered it
+class SlowAddFilter
+    : public SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue> {
+ public:
+  SlowAddFilter(IntQueue& in, IntQueue& out,
+                SpeechTools::FilterExecutor& executor, int offset,
+                std::atomic<bool>& entered)
+      : SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue>(in, out,
+                                                               executor),
+        offset_(offset),
+        entered_(entered) {}
+
+ protected:
+  int process(const int& input_data) override {
+    entered_ = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return input_data + offset_;
+  }
+
+ private:
+  const int offset_;
+  std::atomic<bool>& entered_;
+};
+
+// Counts its turns; used to test the executor without filters
+class CountingTask : public SpeechTools::FilterTask {
+ public:
+  CountingTask() : FilterTask(&CountingTask::run) {}
+
+  std::atomic<int> runs = 0;
+
+ private:
+  static bool run(FilterTask& task) {
+    static_cast<CountingTask&>(task).runs.fetch_add(1);
+    return false;
+  }
+};
+
+// Counts its turns, pops one element per turn and parks on its queue
+class ParkingTask : public SpeechTools::FilterTask {
+ public:
+  ParkingTask()
+      : FilterTask(&ParkingTask::run, &ParkingTask::park,
+                   &ParkingTask::unpark) {}
+
+  SPSCParkingQueue<int> queue{4};
+  std::atomic<int> runs = 0;
+
+ private:
+  static bool run(FilterTask& task) {
+    auto& self = static_cast<ParkingTask&>(task);
+    self.runs.fetch_add(1);
+    int v;
+    return self.queue.try_pop(v);
+  }
+
+  static bool park(FilterTask& task, const QueueWaker& waker) {
+    return static_cast<ParkingTask&>(task).queue.park_consumer(waker);
+  }
+
+  static void unpark(FilterTask& task) {
+    static_cast<ParkingTask&>(task).queue.cancel_consumer_park();
+  }
+};
+
+TEST(FilterExecutorTest, ZeroWorkers) {
+  EXPECT_THROW(SpeechTools::FilterExecutor(0), std::runtime_error);
+}
+
+// More tasks than workers all get turns, and detach stops them
+TEST(FilterExecutorTest, RunsAndDetachesTasks) {
+  SpeechTools::FilterExecutor executor(2);
+  EXPECT_EQ(executor.workerCount(), 2u);
+  std::vector<CountingTask> tasks(6);
+  for (auto& task : tasks) {
+    executor.attach(task);
+  }
+  for (auto& task : tasks) {
+    while (task.runs.load() < 3) {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& task : tasks) {
+    executor.detach(task);
+  }
+  std::vector<int> after;
+  for (auto& task : tasks) {
+    after.push_back(task.runs.load());
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    EXPECT_EQ(tasks[i].runs.load(), after[i]);
+  }
+}
+
+// Idle tasks that can park leave the run queues: they are not polled again
+// until a push into their queue wakes them
+TEST(FilterExecutorTest, ParkedTasksRunOnlyWhenWoken) {
+  SpeechTools::FilterExecutor executor(2);
+  std::vector<ParkingTask> tasks(8);
+  for (auto& task : tasks) {
+    executor.attach(task);
+  }
+  for (auto& task : tasks) {
+    while (task.runs.load() < 1) {
+      std::this_thread::yield();
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  std::vector<int> parked;
+  for (auto& task : tasks) {
+    parked.push_back(task.runs.load());
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    EXPECT_EQ(tasks[i].runs.load(), parked[i]);
+  }
+
+  ParkingTask& woken = tasks[3];
+  EXPECT_TRUE(woken.queue.try_push(1));
+  EXPECT_TRUE(woken.queue.try_push(2));
+  while (!woken.queue.empty()) {
+    std::this_thread::yield();
+  }
+  EXPECT_GT(woken.runs.load(), parked[3]);
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    if (i != 3) {
+      EXPECT_EQ(tasks[i].runs.load(), parked[i]);
+    }
+  }
+  for (auto& task : tasks) {
+    executor.detach(task);
+  }
+  // Detached tasks are not woken any more.
+  int detached = woken.runs.load();
+  EXPECT_TRUE(woken.queue.try_push(3));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_EQ(woken.runs.load(), detached);
+}
+
+// A pipeline of many filters shares two workers
+template <template <typename> class Queue = SPSCLockFreeQueue>
+void runPipeline(size_t max_batch) {
+  constexpr int kStages = 8;
+  constexpr int kCount = 500;
+  SpeechTools::FilterExecutor executor(2);
+  std::vector<std::unique_ptr<Queue<int>>> queues;
+  for (int i = 0; i <= kStages; ++i) {
+    queues.push_back(std::make_unique<Queue<int>>(4));
+  }
+  std::vector<std::unique_ptr<QueueAddFilter<Queue>>> stages;
+  for (int i = 0; i < kStages; ++i) {
+    stages.push_back(std::make_unique<QueueAddFilter<Queue>>(
+        *queues[i], *queues[i + 1], executor, max_batch));
+    stages.back()->start();
+  }
+  std::thread producer([&]() {
+    for (int i = 0; i < kCount; ++i) {
+      queues.front()->push(i);
+    }
+  });
+  for (int i = 0; i < kCount; ++i) {
+    int v;
+    while (!queues.back()->try_pop(v)) {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ(v, i + kStages);
+  }
+  producer.join();
+  for (auto& stage : stages) {
+    stage->stop();
+  }
+}
+
+TEST(FilterExecutorTest, PipelineOnPool) { runPipeline(1); }
+
+// Batches larger than the queues are pushed over several turns
+TEST(FilterExecutorTest, BatchedPipelineOnPool) { runPipeline(6); }
+
+// Filters on parking queues park between frames instead of being polled
+TEST(FilterExecutorTest, ParkingPipelineOnPool) {
+  runPipeline<SPSCParkingQueue>(1);
+}
+
+TEST(FilterExecutorTest, BatchedParkingPipelineOnPool) {
+  runPipeline<SPSCParkingQueue>(6);
+}
+
+// Pooled filters are created stopped; start() attaches them, stop() detaches
+// them and start() attaches them again
+TEST(FilterExecutorTest, StopAndStartPooledFilter) {
+  SpeechTools::FilterExecutor executor(1);
+  IntQueue in(8), out(8);
+  AddFilter filter(in, out, executor);
+  EXPECT_TRUE(in.try_push(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_TRUE(out.empty());
+  filter.start();
+  int v;
+  out.pop(v);
+  EXPECT_EQ(v, 2);
+
+  filter.stop();
+  EXPECT_TRUE(in.try_push(2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_TRUE(out.empty());
+  filter.start();
+  out.pop(v);
+  EXPECT_EQ(v, 3);
+  filter.stop();
+}
+
+// A ScopedFilter is started on construction and can be destroyed while a
+// worker is inside it: the worker finishes its turn on the intact filter
+TEST(FilterExecutorTest, DestroyRunningScopedFilter) {
+  SpeechTools::FilterExecutor executor(1);
+  IntQueue in(8), out(8);
+  std::atomic<bool> entered = false;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(in.try_push(i));
+  }
+  auto filter = std::make_unique<SpeechTools::ScopedFilter<SlowAddFilter>>(
+      in, out, executor, 10, entered);
+  while (!entered.load()) {
+    std::this_thread::yield();
+  }
+  filter.reset();
+  // The turn in progress processed everything queued, then the filter was
+  // detached for good.
+  EXPECT_EQ(out.size(), 4u);
+  for (int i = 0; i < 4; ++i) {
+    int v;
+    EXPECT_TRUE(out.try_pop(v));
+    EXPECT_EQ(v, i + 10);
+  }
+  EXPECT_TRUE(in.try_push(4));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_TRUE(out.empty());
+}
+
+// Turns the first of task_count idle tasks on one worker gets in 50 ms
+int idleTurns(size_t task_count) {
+  SpeechTools::FilterExecutor executor(1);
+  std::vector<CountingTask> tasks(task_count);
+  for (auto& task : tasks) {
+    executor.attach(task);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (auto& task : tasks) {
+    executor.detach(task);
+  }
+  return tasks.front().runs.load();
+}
+
+// A worker sleeps once per idle round, not once per idle task, so how often
+// an idle filter is polled, and with it the wake-up latency of a filter fed
+// from outside the pool, does not depend on how many filters share the worker
+TEST(FilterExecutorTest, IdleRoundsSleepOncePerRound) {
+  int alone = idleTurns(1);
+  int shared = idleTurns(101);
+  // One idle sleep per task would give each of 101 tasks about 100 times
+  // fewer turns.
+  EXPECT_GT(shared * 10, alone);
+}
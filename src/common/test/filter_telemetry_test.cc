@@ -0,0 +1,117 @@
+#include "../src/filter_telemetry.hh"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "../src/speech_filter.hh"
+#include "../src/spsc_queue.hh"
+
+using SpeechTools::FilterTelemetry;
+using SpeechTools::LatencyHistogram;
+
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.percentile(50), 0u);
+  EXPECT_EQ(histogram.max(), 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (uint64_t v = 0; v < 10; ++v) {
+    histogram.record(v);
+  }
+  EXPECT_EQ(histogram.count(), 10u);
+  EXPECT_EQ(histogram.percentile(50), 4u);
+  EXPECT_EQ(histogram.percentile(100), 9u);
+}
+
+// Percentiles of large values are within the 1/16 bucket resolution
+TEST(LatencyHistogramTest, PercentilesWithinResolution) {
+  LatencyHistogram histogram;
+  for (uint64_t v = 1; v <= 100000; ++v) {
+    histogram.record(v * 1000);
+  }
+  for (double percent : {50.0, 90.0, 99.0, 99.9}) {
+    double exact = percent * 1000.0 * 1000.0;
+    double estimate = static_cast<double>(histogram.percentile(percent));
+    EXPECT_GE(estimate, exact * (1.0 - 1.0 / 16));
+    EXPECT_LE(estimate, exact * (1.0 + 1.0 / 16));
+  }
+  EXPECT_EQ(histogram.percentile(100), 100000u * 1000u);
+}
+
+TEST(LatencyHistogramTest, HugeValuesAreClamped) {
+  LatencyHistogram histogram;
+  histogram.record(UINT64_MAX);
+  EXPECT_EQ(histogram.count(), 1u);
+  EXPECT_EQ(histogram.max(), UINT64_MAX);
+}
+
+using IntQueue = SPSCLockFreeQueue<int>;
+constexpr auto kWork = std::chrono::microseconds(200);
+
+// Busy-waits for kWork per frame
+class SlowFilter : public SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue,
+                                                    FilterTelemetry> {
+ public:
+  SlowFilter(IntQueue& in, IntQueue& out)
+      : SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue,
+                                  FilterTelemetry>(in, out) {}
+
+ protected:
+  int process(const int& input_data) override {
+    auto until = std::chrono::steady_clock::now() + kWork;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+    return input_data;
+  }
+};
+
+TEST(FilterTelemetryTest, RecordsProcessTimeAndIdle) {
+  IntQueue in(16), out(16);
+  SlowFilter filter(in, out);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (int i = 0; i < 10; ++i) {
+    in.push(i);
+  }
+  for (int i = 0; i < 10; ++i) {
+    int v;
+    out.pop(v);
+  }
+
+  FilterTelemetry::Snapshot snapshot = filter.telemetry().snapshot();
+  EXPECT_EQ(snapshot.frames, 10u);
+  EXPECT_GE(snapshot.processing, 10 * kWork);
+  // The filter sat idle before the first frame arrived.
+  EXPECT_GE(snapshot.idle, std::chrono::milliseconds(10));
+  EXPECT_GT(snapshot.idleRatio(), 0.0);
+  EXPECT_LE(snapshot.idleRatio(), 1.0);
+  EXPECT_GT(snapshot.framesPerSecond(), 0.0);
+
+  const LatencyHistogram& process_time = filter.telemetry().processTime();
+  EXPECT_EQ(process_time.count(), 10u);
+  EXPECT_GE(process_time.percentile(50),
+            std::chrono::nanoseconds(kWork).count() * 15 / 16);
+}
+
+TEST(FilterTelemetryTest, RecordsOutputBlockedTime) {
+  IntQueue in(16), out(2);
+  SlowFilter filter(in, out);
+  for (int i = 0; i < 4; ++i) {
+    in.push(i);
+  }
+  // The output fills up; the filter blocks until it is drained.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (int i = 0; i < 4; ++i) {
+    int v;
+    out.pop(v);
+  }
+  while (filter.telemetry().snapshot().output_blocked.count() == 0) {
+    std::this_thread::yield();
+  }
+  EXPECT_GE(filter.telemetry().snapshot().output_blocked,
+            std::chrono::milliseconds(5));
+}
@@ -0,0 +1,174 @@
+#include "../src/frame_pool.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+#include "../src/spsc_queue.hh"
+
+using Samples = std::vector<float>;
+using SamplePool = SpeechTools::FramePool<Samples>;
+using SampleFrame = SamplePool::Frame;
+
+TEST(FramePoolTest, ZeroFrames) {
+  EXPECT_THROW(SamplePool(0, Samples(160)), std::runtime_error);
+}
+
+TEST(FramePoolTest, FramesStartAsPrototype) {
+  SamplePool pool(2, Samples(160, 0.5f));
+  SampleFrame frame = pool.acquire();
+  ASSERT_EQ(frame->size(), 160u);
+  EXPECT_FLOAT_EQ((*frame)[0], 0.5f);
+}
+
+TEST(FramePoolTest, DroppedFramesAreReused) {
+  SamplePool pool(1, Samples(160));
+  const float* data;
+  {
+    SampleFrame frame = pool.acquire();
+    data = frame->data();
+    EXPECT_EQ(pool.stats().in_use, 1u);
+  }
+  EXPECT_EQ(pool.stats().in_use, 0u);
+  SampleFrame again = pool.acquire();
+  EXPECT_EQ(again->data(), data);  // Same buffer, not reallocated
+  EXPECT_EQ(pool.stats().misses, 0u);
+}
+
+TEST(FramePoolTest, ExhaustedPoolCountsMisses) {
+  SamplePool pool(2, Samples(160));
+  std::vector<SampleFrame> held;
+  for (int i = 0; i < 5; ++i) {
+    held.push_back(pool.acquire());
+  }
+  SamplePool::Stats stats = pool.stats();
+  EXPECT_EQ(stats.in_use, 5u);
+  EXPECT_EQ(stats.high_water, 5u);
+  EXPECT_EQ(stats.misses, 3u);
+
+  held.clear();
+  stats = pool.stats();
+  EXPECT_EQ(stats.in_use, 0u);
+  EXPECT_EQ(stats.high_water, 5u);
+}
+
+// Extra frames dropped before the pooled ones must not take their place in
+// the return queue
+TEST(FramePoolTest, ExtraFramesReturnedFirst) {
+  SamplePool pool(2, Samples(160));
+  std::vector<SampleFrame> held;
+  for (int i = 0; i < 5; ++i) {
+    held.push_back(pool.acquire());
+  }
+  while (!held.empty()) {
+    held.pop_back();  // Newest, i.e. extra, frames first
+  }
+  EXPECT_EQ(pool.stats().in_use, 0u);
+
+  SampleFrame first = pool.acquire();
+  SampleFrame second = pool.acquire();
+  EXPECT_EQ(pool.stats().misses, 3u);  // Both came from the pool
+}
+
+TEST(FramePoolTest, FramesForCoversQueues) {
+  SPSCLockFreeQueue<SampleFrame> a(8), b(16);
+  EXPECT_EQ(SamplePool::framesFor(a, b), 8u + 16u + 2u + 1u);
+}
+
+// Doubles pooled frames in place and passes them on
+using PooledFilter = SpeechTools::BufferedSpeechFilter<SampleFrame, SampleFrame,
+                                                       SPSCLockFreeQueue>;
+
+class PooledGain : public PooledFilter {
+ public:
+  PooledGain(SPSCLockFreeQueue<SampleFrame>& in,
+             SPSCLockFreeQueue<SampleFrame>& out)
+      : PooledFilter(in, out) {}
+
+ protected:
+  void processInto(SampleFrame& input_data,
+                   SampleFrame& output_data) override {
+    for (float& sample : *input_data) {
+      sample *= 2.0f;
+    }
+    std::swap(input_data, output_data);
+  }
+};
+
+// Frames dropped by the consumer find their way back to the producer, so a
+// pool sized from the queues never misses
+TEST(FramePoolTest, PipelineRecyclesFrames) {
+  constexpr int kFrames = 10000;
+  SPSCLockFreeQueue<SampleFrame> in(8), out(8);
+  SamplePool pool(SamplePool::framesFor(in, out), Samples(160, 1.0f));
+  PooledGain filter(in, out);
+
+  std::thread producer([&] {
+    for (int i = 0; i < kFrames; ++i) {
+      SampleFrame frame = pool.acquire();
+      std::fill(frame->begin(), frame->end(), 1.0f);
+      in.push(std::move(frame));
+    }
+  });
+  for (int i = 0; i < kFrames; ++i) {
+    SampleFrame frame;
+    out.pop(frame);
+    ASSERT_FLOAT_EQ((*frame)[0], 2.0f);
+  }
+  producer.join();
+  filter.stop();
+
+  SamplePool::Stats stats = pool.stats();
+  EXPECT_EQ(stats.misses, 0u);
+  EXPECT_LE(stats.high_water, pool.capacity());
+}
+
+// Converts pooled sample frames to their energy, in frames from a second pool
+class PooledEnergy : public SpeechTools::FramePoolFilter<SampleFrame, float> {
+ public:
+  using SpeechTools::FramePoolFilter<SampleFrame, float>::FramePoolFilter;
+
+ protected:
+  void processPooled(const SampleFrame& input_data,
+                     float& output_data) override {
+    output_data = 0.0f;
+    for (float sample : *input_data) {
+      output_data += sample * sample;
+    }
+  }
+};
+
+// A FramePoolFilter draws its output from one pool and returns its input to
+// another, so neither pool misses
+TEST(FramePoolTest, FilterDrawsAndReturnsFrames) {
+  using EnergyPool = SpeechTools::FramePool<float>;
+  constexpr int kFrames = 10000;
+  SPSCParkingQueue<SampleFrame> in(8);
+  SPSCParkingQueue<EnergyPool::Frame> out(8);
+  SamplePool samples(SamplePool::framesFor(in), Samples(4));
+  EnergyPool energies(EnergyPool::framesFor(out), 0.0f);
+  PooledEnergy filter(energies, in, out);
+
+  std::thread producer([&] {
+    for (int i = 0; i < kFrames; ++i) {
+      SampleFrame frame = samples.acquire();
+      std::fill(frame->begin(), frame->end(), static_cast<float>(i % 4));
+      in.push(std::move(frame));
+    }
+  });
+  for (int i = 0; i < kFrames; ++i) {
+    EnergyPool::Frame frame;
+    out.pop(frame);
+    ASSERT_FLOAT_EQ(*frame, 4.0f * (i % 4) * (i % 4));
+  }
+  producer.join();
+  filter.halt();
+
+  EXPECT_EQ(samples.stats().misses, 0u);
+  EXPECT_EQ(energies.stats().misses, 0u);
+  EXPECT_EQ(energies.stats().in_use, 0u);
+}
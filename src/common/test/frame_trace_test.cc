@@ -0,0 +1,183 @@
+#include "../src/frame_trace.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../src/speech_filter.hh"
+#include "../src/spsc_queue.hh"
+
+using SpeechTools::FrameTrace;
+using SpeechTools::Traced;
+using TracedInt = Traced<int>;
+using TracedQueue = SPSCLockFreeQueue<TracedInt>;
+
+using TracedFilter =
+    SpeechTools::BufferedSpeechFilter<TracedInt, TracedInt, SPSCLockFreeQueue>;
+
+// Adds one to the payload of traced frames
+class TracedIncrement : public TracedFilter {
+ public:
+  TracedIncrement(TracedQueue& in, TracedQueue& out) : TracedFilter(in, out) {}
+
+ protected:
+  void processInto(TracedInt& input_data, TracedInt& output_data) override {
+    output_data.payload = input_data.payload + 1;
+  }
+};
+
+std::string readFile(const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+size_t countOf(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(FrameTraceTest, HopsAreCappedAtMax) {
+  FrameTrace trace = FrameTrace::start(7);
+  for (size_t i = 0; i < SpeechTools::kMaxTraceHops + 2; ++i) {
+    trace.addHop(static_cast<uint16_t>(i), 1, 2);
+  }
+  EXPECT_EQ(trace.sequence, 7u);
+  EXPECT_EQ(trace.hop_count, SpeechTools::kMaxTraceHops);
+}
+
+// Default stages saturate below the sink stage instead of wrapping around
+TEST(FrameTraceTest, StagesSaturateBelowSink) {
+  std::atomic<uint16_t> next = SpeechTools::kMaxFilterTraceStage - 1;
+  EXPECT_EQ(SpeechTools::detail::nextTraceStage(next),
+            SpeechTools::kMaxFilterTraceStage - 1);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(SpeechTools::detail::nextTraceStage(next),
+              SpeechTools::kMaxFilterTraceStage);
+  }
+  EXPECT_LT(SpeechTools::kMaxFilterTraceStage,
+            SpeechTools::FrameTraceWriter::kSinkStage);
+}
+
+// Every filter of a pipeline stamps the frames in order
+TEST(FrameTraceTest, FiltersStampEachHop) {
+  TracedQueue a(8), b(8), c(8);
+  TracedIncrement first(a, b);
+  TracedIncrement second(b, c);
+  EXPECT_NE(first.traceStage(), second.traceStage());
+  second.setTraceStage(42);
+
+  for (uint64_t seq = 0; seq < 5; ++seq) {
+    a.push(TracedInt{static_cast<int>(seq), FrameTrace::start(seq)});
+  }
+  for (uint64_t seq = 0; seq < 5; ++seq) {
+    TracedInt frame;
+    c.pop(frame);
+    EXPECT_EQ(frame.payload, static_cast<int>(seq) + 2);
+    const FrameTrace& trace = frame.trace;
+    EXPECT_EQ(trace.sequence, seq);
+    ASSERT_EQ(trace.hop_count, 2u);
+    EXPECT_EQ(trace.hops[0].stage, first.traceStage());
+    EXPECT_EQ(trace.hops[1].stage, 42u);
+    EXPECT_LE(trace.capture_ns, trace.hops[0].dequeued_ns);
+    EXPECT_LE(trace.hops[0].dequeued_ns, trace.hops[0].processed_ns);
+    EXPECT_LE(trace.hops[0].processed_ns, trace.hops[1].dequeued_ns);
+    EXPECT_LE(trace.hops[1].dequeued_ns, trace.hops[1].processed_ns);
+  }
+}
+
+FrameTrace twoHopTrace(uint64_t sequence) {
+  FrameTrace trace;
+  trace.sequence = sequence;
+  trace.capture_ns = 1'000;
+  trace.addHop(0, 2'000, 3'500);
+  trace.addHop(1, 4'000, 4'250);
+  return trace;
+}
+
+TEST(FrameTraceTest, WritesChromeJson) {
+  auto path = std::filesystem::temp_directory_path() / "frame_trace_test.json";
+  {
+    SpeechTools::FrameTraceWriter writer(path.string(),
+                                         SpeechTools::TraceFormat::kChromeJson);
+    writer.nameStage(0, "denoise");
+    writer.record(twoHopTrace(0), 5'000);
+    writer.record(twoHopTrace(1), 5'000);
+  }
+  std::string json = readFile(path);
+  std::filesystem::remove(path);
+
+  EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0u);
+  EXPECT_NE(json.find("]}"), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"denoise\""), std::string::npos);
+  // Per frame: a queued and a process span per hop, plus the sink's wait.
+  EXPECT_EQ(countOf(json, "\"name\":\"process\""), 4u);
+  EXPECT_EQ(countOf(json, "\"name\":\"queued\""), 6u);
+  // The first hop processed from 2 us for 1.5 us.
+  EXPECT_NE(json.find("\"ts\":2.000,\"dur\":1.500"), std::string::npos);
+}
+
+TEST(FrameTraceTest, WritesBinary) {
+  auto path = std::filesystem::temp_directory_path() / "frame_trace_test.bin";
+  {
+    SpeechTools::FrameTraceWriter writer(path.string(),
+                                         SpeechTools::TraceFormat::kBinary);
+    writer.record(twoHopTrace(0), 5'000);
+  }
+  std::string bytes = readFile(path);
+  std::filesystem::remove(path);
+
+  ASSERT_GE(bytes.size(), 4u);
+  EXPECT_EQ(bytes.substr(0, 4), "SPTR");
+  // Header, then one record: tag, sequence, two times, hop count and hops.
+  constexpr size_t kHopSize = 2 + 8 + 8;
+  EXPECT_EQ(bytes.size(), 4u + 4u + (1 + 8 + 8 + 8 + 1 + 2 * kHopSize));
+}
+
+// Stage names cannot break out of their JSON string
+TEST(FrameTraceTest, EscapesStageNames) {
+  auto path =
+      std::filesystem::temp_directory_path() / "frame_trace_escape_test.json";
+  {
+    SpeechTools::FrameTraceWriter writer(path.string(),
+                                         SpeechTools::TraceFormat::kChromeJson);
+    writer.nameStage(0, "a\"b\\c\n");
+  }
+  std::string json = readFile(path);
+  std::filesystem::remove(path);
+
+  EXPECT_NE(json.find("\"name\":\"a\\\"b\\\\c\\u000a\""),
+            std::string::npos)
+      << json;
+}
+
+// Names longer than the binary length field are cut to fit it
+TEST(FrameTraceTest, BinaryClampsLongStageNames) {
+  auto path =
+      std::filesystem::temp_directory_path() / "frame_trace_name_test.bin";
+  {
+    SpeechTools::FrameTraceWriter writer(path.string(),
+                                         SpeechTools::TraceFormat::kBinary);
+    writer.nameStage(3, std::string(UINT16_MAX + 10, 'x'));
+  }
+  std::string bytes = readFile(path);
+  std::filesystem::remove(path);
+
+  // Header, then tag, stage, length and exactly the clamped name.
+  EXPECT_EQ(bytes.size(), 4u + 4u + (1 + 2 + 2 + size_t{UINT16_MAX}));
+}
+
+TEST(FrameTraceTest, UnwritablePathThrows) {
+  EXPECT_THROW(SpeechTools::FrameTraceWriter("/nonexistent-dir/trace.json",
+                                             SpeechTools::TraceFormat::kBinary),
+               std::runtime_error);
+}
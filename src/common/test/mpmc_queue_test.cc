@@ -0,0 +1,153 @@
+#include "../src/mpmc_queue.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+
+// Basic FIFO test
+TEST(MPMCLockFreeQueueTest, FifoOrder) {
+  MPMCLockFreeQueue<int> q(4);
+  EXPECT_TRUE(q.try_push(1));
+  EXPECT_TRUE(q.try_push(2));
+  EXPECT_TRUE(q.try_push(3));
+  int v;
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 1);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 2);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 3);
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop(v));
+}
+
+// Capacity rounding, full detection and wrap-around
+TEST(MPMCLockFreeQueueTest, FullAndWrapAround) {
+  MPMCLockFreeQueue<int> q(3);
+  EXPECT_EQ(q.capacity(), 4u);
+  int v;
+  for (int round = 0; round < 5; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(q.try_push(round * 4 + i));
+    }
+    EXPECT_TRUE(q.full());
+    EXPECT_FALSE(q.try_push(-1));
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(q.try_pop(v));
+      EXPECT_EQ(v, round * 4 + i);
+    }
+    EXPECT_FALSE(q.try_pop(v));
+  }
+}
+
+// A queue asked for one element still has two slots, so pushing into a full
+// queue fails instead of overwriting the unpopped element
+TEST(MPMCLockFreeQueueTest, CapacityOneRejectsPushWhenFull) {
+  MPMCLockFreeQueue<int> q(1);
+  ASSERT_EQ(q.capacity(), 2u);
+  EXPECT_TRUE(q.try_push(1));
+  EXPECT_TRUE(q.try_push(2));
+  EXPECT_TRUE(q.full());
+  EXPECT_FALSE(q.try_push(3));
+  int v;
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 1);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 2);
+  EXPECT_FALSE(q.try_pop(v));
+}
+
+// Move-only type support and cleanup of leftover elements
+TEST(MPMCLockFreeQueueTest, MoveOnlyType) {
+  auto shared = std::make_shared<int>(1);
+  {
+    MPMCLockFreeQueue<std::shared_ptr<int>> q(4);
+    EXPECT_TRUE(q.try_push(shared));
+    EXPECT_TRUE(q.try_emplace(shared));
+    EXPECT_EQ(shared.use_count(), 3);
+  }
+  EXPECT_EQ(shared.use_count(), 1);
+  MPMCLockFreeQueue<std::unique_ptr<int>> q(2);
+  EXPECT_TRUE(q.try_push(std::make_unique<int>(42)));
+  std::unique_ptr<int> v;
+  EXPECT_TRUE(q.try_pop(v));
+  ASSERT_TRUE(v);
+  EXPECT_EQ(*v, 42);
+}
+
+// Several producers and consumers: every element is received exactly once
+TEST(MPMCLockFreeQueueTest, MultiProducerMultiConsumer) {
+  constexpr int kThreads = 3;
+  constexpr int kPerProducer = 2000;
+  constexpr int kTotal = kThreads * kPerProducer;
+  MPMCLockFreeQueue<int> q(16);
+  std::vector<std::atomic<int>> received(kTotal);
+  std::atomic<int> popped = 0;
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kThreads; ++p) {
+    threads.emplace_back([&, p]() {
+      for (int i = 0; i < kPerProducer; ++i) {
+        while (!q.try_push(p * kPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&]() {
+      int v;
+      while (popped.load() < kTotal) {
+        if (q.try_pop(v)) {
+          received[v].fetch_add(1);
+          popped.fetch_add(1);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  int errors = 0;
+  for (auto& count : received) {
+    errors += count.load() != 1;
+  }
+  EXPECT_EQ(errors, 0);
+  EXPECT_TRUE(q.empty());
+}
+
+// Two filter workers share one MPMC input and output queue
+class IncrementFilter
+    : public SpeechTools::SpeechFilter<int, int, MPMCLockFreeQueue> {
+ public:
+  IncrementFilter(MPMCLockFreeQueue<int>& in, MPMCLockFreeQueue<int>& out)
+      : SpeechTools::SpeechFilter<int, int, MPMCLockFreeQueue>(in, out) {}
+
+ protected:
+  int process(const int& input_data) override { return input_data + 1; }
+};
+
+TEST(MPMCLockFreeQueueTest, SharedByFilterWorkers) {
+  static_assert(SpeechTools::QueueWithValueType<MPMCLockFreeQueue<int>, int>);
+  MPMCLockFreeQueue<int> in(16), out(16);
+  IncrementFilter worker_a(in, out);
+  IncrementFilter worker_b(in, out);
+  int sum = 0;
+  for (int i = 0; i < 10; ++i) {
+    while (!in.try_push(i)) {
+      std::this_thread::yield();
+    }
+  }
+  for (int i = 0; i < 10; ++i) {
+    int v;
+    while (!out.try_pop(v)) {
+      std::this_thread::yield();
+    }
+    sum += v;
+  }
+  EXPECT_EQ(sum, 55);
+}
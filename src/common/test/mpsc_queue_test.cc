@@ -0,0 +1,152 @@
+#include "../src/mpsc_queue.hh"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+
+// Basic FIFO test
+TEST(MPSCLockFreeQueueTest, FifoOrder) {
+  MPSCLockFreeQueue<int> q(4);
+  EXPECT_TRUE(q.try_push(1));
+  EXPECT_TRUE(q.try_push(2));
+  EXPECT_TRUE(q.try_push(3));
+  int v;
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 1);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 2);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 3);
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop(v));
+}
+
+// Capacity rounding, full detection and wrap-around
+TEST(MPSCLockFreeQueueTest, FullAndWrapAround) {
+  MPSCLockFreeQueue<int> q(3);
+  EXPECT_EQ(q.capacity(), 4u);
+  int v;
+  for (int round = 0; round < 5; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(q.try_push(round * 4 + i));
+    }
+    EXPECT_TRUE(q.full());
+    EXPECT_EQ(q.size(), 4u);
+    EXPECT_FALSE(q.try_push(-1));
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(q.try_pop(v));
+      EXPECT_EQ(v, round * 4 + i);
+    }
+    EXPECT_FALSE(q.try_pop(v));
+  }
+}
+
+// A queue asked for one element still has two slots, so pushing into a full
+// queue fails instead of overwriting the unpopped element
+TEST(MPSCLockFreeQueueTest, CapacityOneRejectsPushWhenFull) {
+  MPSCLockFreeQueue<int> q(1);
+  ASSERT_EQ(q.capacity(), 2u);
+  EXPECT_TRUE(q.try_push(1));
+  EXPECT_TRUE(q.try_push(2));
+  EXPECT_TRUE(q.full());
+  EXPECT_FALSE(q.try_push(3));
+  int v;
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 1);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 2);
+  EXPECT_FALSE(q.try_pop(v));
+}
+
+// Move-only type support and cleanup of leftover elements
+TEST(MPSCLockFreeQueueTest, MoveOnlyType) {
+  auto shared = std::make_shared<int>(1);
+  {
+    MPSCLockFreeQueue<std::shared_ptr<int>> q(4);
+    EXPECT_TRUE(q.try_push(shared));
+    EXPECT_TRUE(q.try_emplace(shared));
+    EXPECT_EQ(shared.use_count(), 3);
+    std::shared_ptr<int> v;
+    EXPECT_TRUE(q.try_pop(v));
+    v.reset();
+    EXPECT_EQ(shared.use_count(), 2);
+  }
+  EXPECT_EQ(shared.use_count(), 1);
+  MPSCLockFreeQueue<std::unique_ptr<int>> q(2);
+  EXPECT_TRUE(q.try_push(std::make_unique<int>(42)));
+  std::unique_ptr<int> v;
+  EXPECT_TRUE(q.try_pop(v));
+  ASSERT_TRUE(v);
+  EXPECT_EQ(*v, 42);
+}
+
+// Several producers, one consumer: nothing lost or duplicated and each
+// producer's elements arrive in order
+TEST(MPSCLockFreeQueueTest, MultiProducerConcurrent) {
+  constexpr int kProducers = 4;
+  constexpr int kPerProducer = 2000;
+  MPSCLockFreeQueue<int> q(32);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p]() {
+      for (int i = 0; i < kPerProducer; ++i) {
+        while (!q.try_push(p * kPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::vector<int> last(kProducers, -1);
+  int received = 0;
+  int errors = 0;
+  while (received < kProducers * kPerProducer) {
+    int v;
+    if (!q.try_pop(v)) {
+      std::this_thread::yield();
+      continue;
+    }
+    int p = v / kPerProducer;
+    errors += (v % kPerProducer) != last[p] + 1;
+    last[p] = v % kPerProducer;
+    ++received;
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  EXPECT_EQ(errors, 0);
+  EXPECT_TRUE(q.empty());
+}
+
+// The MPSC queue plugs into SpeechFilter as its input queue
+class IncrementFilter
+    : public SpeechTools::SpeechFilter<int, int, MPSCLockFreeQueue> {
+ public:
+  IncrementFilter(MPSCLockFreeQueue<int>& in, MPSCLockFreeQueue<int>& out)
+      : SpeechTools::SpeechFilter<int, int, MPSCLockFreeQueue>(in, out) {}
+
+ protected:
+  int process(const int& input_data) override { return input_data + 1; }
+};
+
+TEST(MPSCLockFreeQueueTest, PlugsIntoSpeechFilter) {
+  static_assert(SpeechTools::QueueWithValueType<MPSCLockFreeQueue<int>, int>);
+  MPSCLockFreeQueue<int> in(16), out(16);
+  IncrementFilter filter(in, out);
+  std::thread a([&]() { in.try_push(10); });
+  std::thread b([&]() { in.try_push(20); });
+  a.join();
+  b.join();
+  int sum = 0;
+  for (int i = 0; i < 2; ++i) {
+    int v;
+    while (!out.try_pop(v)) {
+      std::this_thread::yield();
+    }
+    sum += v;
+  }
+  EXPECT_EQ(sum, 32);
+}
@@ -1,5 +1,20 @@
 #include "../src/speech_filter.hh"
 
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../src/cooperative_scheduler.hh"
+#include "../src/filter_executor.hh"
 #include "../src/spsc_queue.hh"
 #include "gtest/gtest.h"
 
@@ -11,6 +26,10 @@ class DummyFilter
  public:
   DummyFilter(SPSCLockFreeQueue<int>& in, SPSCLockFreeQueue<int>& out)
       : SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue>(in, out) {}
+  DummyFilter(SPSCLockFreeQueue<int>& in, SPSCLockFreeQueue<int>& out,
+              SpeechTools::CooperativeScheduler& scheduler)
+      : SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue>(in, out,
+                                                               scheduler) {}
 
  protected:
   virtual int process(const int& input_data) override { return input_data * 2; }
@@ -27,22 +46,474 @@ TEST(SpeechFilterTest, ConstructionAndDestruction) {
 
 TEST(SpeechFilterTest, StartAndStopProcessing) {
   IntQueue in(8), out(8);
-  DummyFilter filter(in, out);
+  SpeechTools::CooperativeScheduler scheduler;
+  DummyFilter filter(in, out, scheduler);
 
   // Add input
   in.try_push(3);
   in.try_push(7);
 
-  // Wait for processing
-  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  // Process everything queued, on this thread
+  scheduler.runUntilIdle();
 
   int val1 = 0, val2 = 0;
   bool got1 = out.try_pop(val1);
   bool got2 = out.try_pop(val2);
 
-  // The filter should have processed both values
+  // The filter should have processed both values, in order
   EXPECT_TRUE(got1);
   EXPECT_TRUE(got2);
-  EXPECT_TRUE((val1 == 6 && val2 == 14) || (val1 == 14 && val2 == 6))
-      << "Actual: " << val1 << " " << val2 << "\n";
-}
\ No newline at end of file
+  EXPECT_EQ(val1, 6);
+  EXPECT_EQ(val2, 14);
+
+  // A stopped filter is not run; a restarted one picks up where it left off
+  filter.stop();
+  in.try_push(5);
+  scheduler.runUntilIdle();
+  EXPECT_TRUE(out.empty());
+  filter.start();
+  scheduler.runUntilIdle();
+  int val3 = 0;
+  EXPECT_TRUE(out.try_pop(val3));
+  EXPECT_EQ(val3, 10);
+}
+
+// Same filter with a selectable wait strategy, over the default queues, which
+// can park
+using ParkingQueue = SPSCParkingQueue<int>;
+
+class StrategyFilter : public SpeechTools::SpeechFilter<int, int> {
+ public:
+  StrategyFilter(ParkingQueue& in, ParkingQueue& out,
+                 SpeechTools::WaitStrategy wait)
+      : SpeechTools::SpeechFilter<int, int>(in, out, wait) {}
+
+ protected:
+  int process(const int& input_data) override { return input_data * 2; }
+};
+
+// Every strategy processes data, including after the thread went idle
+TEST(SpeechFilterTest, WaitStrategiesProcess) {
+  using SpeechTools::WaitStrategy;
+  for (WaitStrategy wait : {WaitStrategy::kBusySpin, WaitStrategy::kYield,
+                            WaitStrategy::kPark}) {
+    ParkingQueue in(8), out(8);
+    StrategyFilter filter(in, out, wait);
+    for (int i = 0; i < 3; ++i) {
+      // Give the filter time to escalate to its idle wait.
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      in.push(i);
+      int v;
+      out.pop(v);
+      EXPECT_EQ(v, i * 2);
+    }
+  }
+}
+
+// stop() interrupts a filter thread parked on an empty input queue
+TEST(SpeechFilterTest, StopWakesParkedFilter) {
+  ParkingQueue in(8), out(8);
+  auto start = std::chrono::steady_clock::now();
+  {
+    StrategyFilter filter(in, out, SpeechTools::WaitStrategy::kPark);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  // The destructor joined the thread instead of hanging.
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+// CPU time used by the whole process so far
+static std::chrono::microseconds processCpuTime() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         std::chrono::microseconds(usage.ru_utime.tv_usec +
+                                   usage.ru_stime.tv_usec);
+}
+
+// On the default queues, an idle kPark filter and a consumer blocked in pop()
+// on its output both sleep instead of spinning
+TEST(SpeechFilterTest, DefaultQueueParksWhileIdle) {
+  ParkingQueue in(8), out(8);
+  StrategyFilter filter(in, out, SpeechTools::WaitStrategy::kPark);
+  std::atomic<bool> waiting = false;
+  int v = 0;
+  std::thread consumer([&]() {
+    waiting = true;
+    out.pop(v);
+  });
+  while (!waiting) {
+    std::this_thread::yield();
+  }
+  // Let both threads get past their spin and yield phases first.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  auto before = processCpuTime();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  auto used = processCpuTime() - before;
+  in.push(21);
+  consumer.join();
+  EXPECT_EQ(v, 42);
+  // Two spinning threads would use about 200ms each.
+  EXPECT_LT(used, std::chrono::milliseconds(50));
+}
+
+// Counts heap allocations made through the global operator new
+namespace {
+std::atomic<size_t> g_allocations = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+// GCC pairs the inlined malloc above with these frees and warns spuriously.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+using Frame = std::vector<float>;
+
+using FrameFilter =
+    SpeechTools::BufferedSpeechFilter<Frame, Frame, SPSCLockFreeQueue>;
+
+// Scales a frame in place and passes its buffer on
+class InPlaceGain : public FrameFilter {
+ public:
+  InPlaceGain(SPSCLockFreeQueue<Frame>& in, SPSCLockFreeQueue<Frame>& out)
+      : FrameFilter(in, out) {}
+
+ protected:
+  void processInto(Frame& input_data, Frame& output_data) override {
+    for (float& sample : input_data) {
+      sample *= 2.0f;
+    }
+    std::swap(input_data, output_data);
+  }
+};
+
+// In steady state an in-place filter makes no heap allocations per frame
+TEST(SpeechFilterTest, InPlaceProcessingDoesNotAllocate) {
+  constexpr size_t kFrames = 64;
+  SPSCLockFreeQueue<Frame> in(kFrames), out(kFrames);
+  std::vector<Frame> frames(kFrames, Frame(160, 1.0f));
+  std::vector<Frame> results(kFrames);
+  InPlaceGain filter(in, out);
+
+  size_t before = g_allocations.load();
+  for (Frame& frame : frames) {
+    in.push(std::move(frame));
+  }
+  for (Frame& result : results) {
+    out.pop(result);
+  }
+  size_t allocations = g_allocations.load() - before;
+
+  EXPECT_EQ(allocations, 0u);
+  for (const Frame& result : results) {
+    ASSERT_EQ(result.size(), 160u);
+    EXPECT_FLOAT_EQ(result[0], 2.0f);
+  }
+}
+
+using WideFrame = std::vector<double>;
+
+// Writes a widened copy of each frame into its output buffer, without swapping
+class WidenFilter
+    : public SpeechTools::BufferedSpeechFilter<Frame, WideFrame,
+                                               SPSCLockFreeQueue> {
+ public:
+  WidenFilter(SPSCLockFreeQueue<Frame>& in, SPSCLockFreeQueue<WideFrame>& out)
+      : SpeechTools::BufferedSpeechFilter<Frame, WideFrame, SPSCLockFreeQueue>(
+            in, out) {}
+
+ protected:
+  void processInto(Frame& input_data, WideFrame& output_data) override {
+    output_data.assign(input_data.begin(), input_data.end());
+  }
+};
+
+// A filter writing into claimed output slots reuses the frames its consumer
+// released there, so in steady state it makes no heap allocations either
+TEST(SpeechFilterTest, ClaimedOutputSlotsDoNotAllocate) {
+  static_assert(SpeechTools::ClaimQueue<SPSCLockFreeQueue<WideFrame>>);
+  constexpr size_t kFrames = 64;
+  // Enough to send every output slot around once.
+  constexpr size_t kWarmUp = 8;
+  SPSCLockFreeQueue<Frame> in(kFrames);
+  SPSCLockFreeQueue<WideFrame> out(4);
+  std::vector<Frame> frames(kFrames, Frame(160, 1.0f));
+  std::vector<double> firsts(kFrames);
+  WidenFilter filter(in, out);
+  auto consume = [&](size_t i) {
+    const WideFrame* result;
+    while ((result = out.peek_read()) == nullptr) {
+      std::this_thread::yield();
+    }
+    firsts[i] = result->size() == 160 ? (*result)[0] : -1.0;
+    out.release_read();
+  };
+
+  for (Frame& frame : frames) {
+    in.push(std::move(frame));
+  }
+  for (size_t i = 0; i < kWarmUp; ++i) {
+    consume(i);
+  }
+  size_t before = g_allocations.load();
+  for (size_t i = kWarmUp; i < kFrames; ++i) {
+    consume(i);
+  }
+  size_t allocations = g_allocations.load() - before;
+
+  EXPECT_EQ(allocations, 0u);
+  for (double first : firsts) {
+    EXPECT_DOUBLE_EQ(first, 1.0);
+  }
+}
+
+// Doubles frames in batches and records the size of every batch
+class BatchFilter
+    : public SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue> {
+ public:
+  BatchFilter(IntQueue& in, IntQueue& out, size_t max_batch)
+      : SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue>(
+            in, out, SpeechTools::WaitStrategy::kYield, max_batch) {}
+
+  std::atomic<size_t> largest_batch = 0;
+
+ protected:
+  int process(const int& input_data) override { return input_data * 2; }
+
+  void processBatch(std::span<int> input_data,
+                    std::span<int> output_data) override {
+    if (input_data.size() > largest_batch.load()) {
+      largest_batch.store(input_data.size());
+    }
+    SpeechFilter::processBatch(input_data, output_data);
+  }
+};
+
+// A filter that implements neither process() nor processInto() cannot be
+// instantiated
+class NoHooksFilter
+    : public SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue> {};
+class NoHooksBufferedFilter
+    : public SpeechTools::BufferedSpeechFilter<int, int, SPSCLockFreeQueue> {};
+static_assert(std::is_abstract_v<NoHooksFilter>);
+static_assert(std::is_abstract_v<NoHooksBufferedFilter>);
+
+using IntPtr = std::unique_ptr<int>;
+
+// Reads move-only frames through process() and emits their values
+class DerefFilter
+    : public SpeechTools::SpeechFilter<IntPtr, int, SPSCLockFreeQueue> {
+ public:
+  DerefFilter(SPSCLockFreeQueue<IntPtr>& in, IntQueue& out, size_t max_batch)
+      : SpeechTools::SpeechFilter<IntPtr, int, SPSCLockFreeQueue>(
+            in, out, SpeechTools::WaitStrategy::kYield, max_batch) {}
+
+ protected:
+  int process(const IntPtr& input_data) override { return *input_data; }
+};
+
+// process() handles move-only frames, one at a time and in batches
+TEST(SpeechFilterTest, MoveOnlyFramesThroughProcess) {
+  for (size_t max_batch : {size_t{1}, size_t{4}}) {
+    SPSCLockFreeQueue<IntPtr> in(16);
+    IntQueue out(16);
+    DerefFilter filter(in, out, max_batch);
+    for (int i = 0; i < 10; ++i) {
+      in.push(std::make_unique<int>(i));
+    }
+    for (int i = 0; i < 10; ++i) {
+      int v;
+      out.pop(v);
+      EXPECT_EQ(v, i);
+    }
+  }
+}
+
+TEST(SpeechFilterTest, ZeroBatchSize) {
+  IntQueue in(8), out(8);
+  EXPECT_THROW(BatchFilter(in, out, 0), std::runtime_error);
+}
+
+// A backlog is taken in batches of at most max_batch, in order
+TEST(SpeechFilterTest, BatchesDrainBacklog) {
+  constexpr int kFrames = 100;
+  IntQueue in(128), out(128);
+  BatchFilter filter(in, out, 16);
+  std::vector<int> frames(kFrames);
+  for (int i = 0; i < kFrames; ++i) {
+    frames[i] = i;
+  }
+  // Published at once, so the filter finds a backlog.
+  ASSERT_EQ(in.try_push_n(std::span<const int>(frames)), size_t{kFrames});
+  for (int i = 0; i < kFrames; ++i) {
+    int v;
+    out.pop(v);
+    EXPECT_EQ(v, i * 2);
+  }
+  EXPECT_GT(filter.largest_batch.load(), 1u);
+  EXPECT_LE(filter.largest_batch.load(), 16u);
+}
+
+using MaybeInt = std::optional<int>;
+using MaybeQueue = SPSCLockFreeQueue<MaybeInt>;
+using MaybeFilter =
+    SpeechTools::SpeechFilter<MaybeInt, MaybeInt, SPSCLockFreeQueue>;
+
+// Adds a carry from the previous frame, like an overlap-add tail, and emits
+// the last carry on flush()
+class CarryFilter : public MaybeFilter {
+ public:
+  CarryFilter(MaybeQueue& in, MaybeQueue& out, size_t max_batch = 1)
+      : MaybeFilter(in, out, SpeechTools::WaitStrategy::kYield, max_batch) {}
+  CarryFilter(MaybeQueue& in, MaybeQueue& out,
+              SpeechTools::FilterExecutor& executor, size_t max_batch = 1)
+      : MaybeFilter(in, out, executor, max_batch) {}
+  CarryFilter(MaybeQueue& in, MaybeQueue& out,
+              SpeechTools::CooperativeScheduler& scheduler)
+      : MaybeFilter(in, out, scheduler) {}
+
+ protected:
+  MaybeInt process(const MaybeInt& input_data) override {
+    int output = *input_data + carry_;
+    carry_ = 1000;
+    return output;
+  }
+
+  bool flush(MaybeInt& output_data) override {
+    if (carry_ == 0) {
+      return false;
+    }
+    output_data = carry_;
+    carry_ = 0;
+    return true;
+  }
+
+ private:
+  int carry_ = 0;
+};
+
+// Pops frames up to and including the end-of-stream marker
+std::vector<int> popStream(MaybeQueue& queue) {
+  std::vector<int> frames;
+  MaybeInt frame;
+  while (queue.try_pop(frame) && frame) {
+    frames.push_back(*frame);
+  }
+  EXPECT_FALSE(frame.has_value()) << "missing end-of-stream marker";
+  return frames;
+}
+
+std::vector<int> expectedStream(int frames) {
+  std::vector<int> expected;
+  for (int i = 0; i < frames; ++i) {
+    expected.push_back(i + (i > 0 ? 1000 : 0));
+  }
+  expected.push_back(1000);  // The flushed tail
+  return expected;
+}
+
+// drain() processes everything queued, flushes and ends the stream, with
+// frames one at a time and in batches
+TEST(SpeechFilterTest, DrainProcessesQueuedFramesAndFlushes) {
+  constexpr int kFrames = 50;
+  for (size_t max_batch : {size_t{1}, size_t{8}}) {
+    MaybeQueue in(64), out(64);
+    CarryFilter filter(in, out, max_batch);
+    for (int i = 0; i < kFrames; ++i) {
+      in.push(i);
+    }
+    filter.drain();
+    EXPECT_TRUE(filter.finished());
+    EXPECT_EQ(popStream(out), expectedStream(kFrames));
+    EXPECT_TRUE(out.empty());
+  }
+}
+
+// A filter that finished on an end-of-stream marker is restarted by start()
+TEST(SpeechFilterTest, StartAfterEndOfStream) {
+  for (size_t max_batch : {size_t{1}, size_t{8}}) {
+    MaybeQueue in(8), out(8);
+    CarryFilter filter(in, out, max_batch);
+    for (int round = 0; round < 2; ++round) {
+      for (int i = 0; i < 3; ++i) {
+        in.push(i);
+      }
+      in.push(std::nullopt);
+      while (!filter.finished()) {
+        std::this_thread::yield();
+      }
+      EXPECT_EQ(popStream(out), expectedStream(3));
+      filter.start();
+    }
+  }
+}
+
+// The end-of-stream marker drains downstream filters, even when the output
+// has to be consumed while draining
+TEST(SpeechFilterTest, DrainPropagatesThroughPipeline) {
+  constexpr int kFrames = 100;
+  MaybeQueue a(4), b(4), c(4);
+  CarryFilter first(a, b);
+  CarryFilter second(b, c, 3);
+  std::vector<int> received;
+  std::thread sink([&] {
+    MaybeInt frame;
+    do {
+      c.pop(frame);
+      if (frame) {
+        received.push_back(*frame);
+      }
+    } while (frame);
+  });
+  for (int i = 0; i < kFrames; ++i) {
+    a.push(i);
+  }
+  first.drain();
+  sink.join();
+  EXPECT_TRUE(second.finished());
+  second.drain();  // Already finished; joins the thread
+  ASSERT_EQ(received.size(), kFrames + 2u);
+  EXPECT_EQ(received[0], 0);
+  EXPECT_EQ(received[1], 2001);  // Both filters' carries
+  EXPECT_EQ(received[kFrames], 2000);  // First tail plus second carry
+  EXPECT_EQ(received[kFrames + 1], 1000);  // Second tail
+}
+
+TEST(SpeechFilterTest, DrainPooledFilter) {
+  constexpr int kFrames = 50;
+  for (size_t max_batch : {size_t{1}, size_t{8}}) {
+    SpeechTools::FilterExecutor executor(2);
+    MaybeQueue in(64), out(64);
+    CarryFilter filter(in, out, executor, max_batch);
+    filter.start();
+    for (int i = 0; i < kFrames; ++i) {
+      in.push(i);
+    }
+    filter.drain();
+    EXPECT_TRUE(filter.finished());
+    EXPECT_EQ(popStream(out), expectedStream(kFrames));
+  }
+}
+
+TEST(SpeechFilterTest, DrainCooperativeFilter) {
+  SpeechTools::CooperativeScheduler scheduler;
+  MaybeQueue in(8), out(8);
+  CarryFilter filter(in, out, scheduler);
+  for (int i = 0; i < 5; ++i) {
+    in.push(i);
+  }
+  filter.drain();
+  EXPECT_TRUE(filter.finished());
+  EXPECT_EQ(scheduler.taskCount(), 0u);
+  EXPECT_EQ(popStream(out), expectedStream(5));
+}
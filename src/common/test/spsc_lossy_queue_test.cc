@@ -0,0 +1,183 @@
+#include "../src/spsc_lossy_queue.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+
+// Behaves like a FIFO while there is room
+TEST(SPSCLossyQueueTest, FifoOrder) {
+  SPSCLossyQueue<int> q(4);
+  EXPECT_TRUE(q.try_push(1));
+  EXPECT_TRUE(q.try_push(2));
+  int v;
+  size_t skipped = 99;
+  EXPECT_TRUE(q.try_pop(v, skipped));
+  EXPECT_EQ(v, 1);
+  EXPECT_EQ(skipped, 0u);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 2);
+  EXPECT_FALSE(q.try_pop(v));
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(q.dropped(), 0u);
+}
+
+// A push into a full queue discards the oldest element and reports the gap
+TEST(SPSCLossyQueueTest, OverwritesOldest) {
+  SPSCLossyQueue<int> q(3);
+  EXPECT_EQ(q.capacity(), 4u);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(q.try_push(i));
+  }
+  EXPECT_TRUE(q.full());
+  EXPECT_TRUE(q.try_push(4));
+  EXPECT_TRUE(q.try_push(5));
+  EXPECT_EQ(q.dropped(), 2u);
+  EXPECT_EQ(q.size(), 4u);
+  int v;
+  size_t skipped;
+  EXPECT_TRUE(q.try_pop(v, skipped));
+  EXPECT_EQ(v, 2);
+  EXPECT_EQ(skipped, 2u);
+  for (int i = 3; i < 6; ++i) {
+    EXPECT_TRUE(q.try_pop(v, skipped));
+    EXPECT_EQ(v, i);
+    EXPECT_EQ(skipped, 0u);
+  }
+  EXPECT_FALSE(q.try_pop(v));
+}
+
+// Discarded and leftover elements are destroyed
+TEST(SPSCLossyQueueTest, DestroysDiscardedElements) {
+  auto shared = std::make_shared<int>(1);
+  {
+    SPSCLossyQueue<std::shared_ptr<int>> q(2);
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_TRUE(q.try_push(shared));
+    }
+    EXPECT_EQ(shared.use_count(), 3);
+    EXPECT_EQ(q.dropped(), 3u);
+  }
+  EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(SPSCLossyQueueTest, ZeroCapacity) {
+  EXPECT_THROW(SPSCLossyQueue<int>(0), std::runtime_error);
+}
+
+// A producer that never waits: the consumer sees an increasing sequence and
+// every element is either popped or counted as dropped
+TEST(SPSCLossyQueueTest, ConcurrentProducerNeverBlocks) {
+  constexpr int kCount = 20000;
+  SPSCLossyQueue<int> q(8);
+  std::atomic<bool> done = false;
+  uint64_t popped = 0;
+  uint64_t skipped_total = 0;
+  int last = -1;
+  std::thread consumer([&]() {
+    int v;
+    size_t skipped;
+    for (;;) {
+      bool finished = done.load();
+      if (q.try_pop(v, skipped)) {
+        EXPECT_EQ(v, last + 1 + static_cast<int>(skipped));
+        last = v;
+        ++popped;
+        skipped_total += skipped;
+      } else if (finished) {
+        break;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (int i = 0; i < kCount; ++i) {
+    EXPECT_TRUE(q.try_push(i));
+  }
+  done.store(true);
+  consumer.join();
+  // Pushes dropped after the last popped element are not reported as a gap
+  // yet; every other drop is.
+  EXPECT_EQ(skipped_total + static_cast<uint64_t>(kCount - 1 - last),
+            q.dropped());
+  EXPECT_EQ(popped + q.dropped(), static_cast<uint64_t>(kCount));
+}
+
+// Holds the consumer inside try_pop() while the test flag is set
+struct SlowMove {
+  static inline std::atomic<bool> hold = false;
+  static inline std::atomic<bool> moving = false;
+
+  SlowMove() = default;
+  SlowMove(int v) : value(v) {}
+  SlowMove(const SlowMove&) = default;
+  SlowMove(SlowMove&&) = default;
+  SlowMove& operator=(SlowMove&& other) {
+    moving = true;
+    while (hold.load()) {
+      std::this_thread::yield();
+    }
+    value = other.value;
+    return *this;
+  }
+
+  int value = 0;
+};
+
+// A push into a full queue whose oldest element is being popped drops the
+// pushed element instead of waiting for the consumer
+TEST(SPSCLossyQueueTest, DropsIncomingWhileOldestIsBusy) {
+  SPSCLossyQueue<SlowMove> q(2);
+  EXPECT_TRUE(q.try_push(SlowMove(0)));
+  EXPECT_TRUE(q.try_push(SlowMove(1)));
+  SlowMove::moving = false;
+  SlowMove::hold = true;
+  SlowMove popped;
+  size_t skipped = 99;
+  std::thread consumer([&]() { EXPECT_TRUE(q.try_pop(popped, skipped)); });
+  while (!SlowMove::moving.load()) {
+    std::this_thread::yield();
+  }
+  EXPECT_TRUE(q.try_push(SlowMove(2)));
+  EXPECT_TRUE(q.try_push(SlowMove(3)));
+  EXPECT_EQ(q.dropped(), 2u);
+  SlowMove::hold = false;
+  consumer.join();
+  EXPECT_EQ(popped.value, 0);
+  EXPECT_EQ(skipped, 0u);
+
+  EXPECT_TRUE(q.try_push(SlowMove(4)));
+  EXPECT_TRUE(q.try_pop(popped, skipped));
+  EXPECT_EQ(popped.value, 1);
+  EXPECT_EQ(skipped, 0u);
+  EXPECT_TRUE(q.try_pop(popped, skipped));
+  EXPECT_EQ(popped.value, 4);
+  EXPECT_EQ(skipped, 2u);
+}
+
+// The lossy queue plugs into SpeechFilter; its output never stalls the loop
+class IncrementFilter
+    : public SpeechTools::SpeechFilter<int, int, SPSCLossyQueue> {
+ public:
+  IncrementFilter(SPSCLossyQueue<int>& in, SPSCLossyQueue<int>& out)
+      : SpeechTools::SpeechFilter<int, int, SPSCLossyQueue>(in, out) {}
+
+ protected:
+  int process(const int& input_data) override { return input_data + 1; }
+};
+
+TEST(SPSCLossyQueueTest, PlugsIntoSpeechFilter) {
+  static_assert(SpeechTools::QueueWithValueType<SPSCLossyQueue<int>, int>);
+  SPSCLossyQueue<int> in(16), out(16);
+  IncrementFilter filter(in, out);
+  EXPECT_TRUE(in.try_push(41));
+  int v;
+  while (!out.try_pop(v)) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(v, 42);
+}
@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include <set>
 #include <thread>
 
 // Basic FIFO test
@@ -184,3 +185,616 @@ TEST(SPSCLockFreeQueueTest, SPSCProducerSlowConsumerFast) {
     EXPECT_EQ(results[i], i);
   }
 }
+
+// Batch push/pop preserves FIFO order
+TEST(SPSCLockFreeQueueTest, BatchFifoOrder) {
+  SPSCLockFreeQueue<int> q(8);
+  std::vector<int> in{1, 2, 3, 4, 5};
+  EXPECT_EQ(q.try_push_n(in), 5u);
+  EXPECT_EQ(q.size(), 5u);
+  std::vector<int> out(5);
+  EXPECT_EQ(q.try_pop_n(out), 5u);
+  EXPECT_EQ(out, in);
+  EXPECT_TRUE(q.empty());
+}
+
+// Batch operations transfer only what fits or what is available
+TEST(SPSCLockFreeQueueTest, BatchPartial) {
+  SPSCLockFreeQueue<int> q(4);
+  std::vector<int> in{1, 2, 3, 4, 5, 6};
+  EXPECT_EQ(q.try_push_n(in), 4u);
+  EXPECT_TRUE(q.full());
+  EXPECT_EQ(q.try_push_n(in), 0u);
+  std::vector<int> out(6, 0);
+  EXPECT_EQ(q.try_pop_n(out), 4u);
+  EXPECT_EQ(out, (std::vector<int>{1, 2, 3, 4, 0, 0}));
+  EXPECT_EQ(q.try_pop_n(out), 0u);
+}
+
+// Batch operations across the end of the circular buffer
+TEST(SPSCLockFreeQueueTest, BatchWrapAround) {
+  SPSCLockFreeQueue<int> q(5);
+  std::vector<int> out;
+  int next = 0;
+  for (int round = 0; round < 10; ++round) {
+    std::vector<int> in{next, next + 1, next + 2};
+    next += 3;
+    ASSERT_EQ(q.try_push_n(in.begin(), in.size()), 3u);
+    ASSERT_EQ(q.size(), 3u);
+    ASSERT_EQ(q.try_pop_n(std::back_inserter(out), 3), 3u);
+  }
+  ASSERT_EQ(out.size(), 30u);
+  for (int i = 0; i < 30; ++i) {
+    EXPECT_EQ(out[i], i);
+  }
+}
+
+// Batch push of move-only elements
+TEST(SPSCLockFreeQueueTest, BatchMoveOnlyType) {
+  SPSCLockFreeQueue<std::unique_ptr<int>> q(4);
+  std::vector<std::unique_ptr<int>> in;
+  in.push_back(std::make_unique<int>(1));
+  in.push_back(std::make_unique<int>(2));
+  EXPECT_EQ(q.try_push_n(std::make_move_iterator(in.begin()), in.size()), 2u);
+  std::unique_ptr<int> out[2];
+  EXPECT_EQ(q.try_pop_n(std::span(out)), 2u);
+  ASSERT_TRUE(out[0] && out[1]);
+  EXPECT_EQ(*out[0], 1);
+  EXPECT_EQ(*out[1], 2);
+}
+
+// Batch producer and batch consumer running concurrently
+TEST(SPSCLockFreeQueueTest, BatchConcurrent) {
+  SPSCLockFreeQueue<int> q(64);
+  std::vector<int> results;
+  std::thread producer([&]() {
+    int buf[16];
+    for (int i = 0; i < 1000;) {
+      int n = std::min(16, 1000 - i);
+      for (int j = 0; j < n; ++j) {
+        buf[j] = i + j;
+      }
+      size_t pushed = 0;
+      while (pushed < static_cast<size_t>(n)) {
+        pushed += q.try_push_n(std::span<const int>(buf + pushed, n - pushed));
+      }
+      i += n;
+    }
+  });
+  std::thread consumer([&]() {
+    int buf[7];
+    while (results.size() < 1000) {
+      size_t n = q.try_pop_n(buf);
+      results.insert(results.end(), buf, buf + n);
+    }
+  });
+  producer.join();
+  consumer.join();
+  ASSERT_EQ(results.size(), 1000u);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(results[i], i);
+  }
+}
+
+// Producer and consumer indices must not share a cache line
+TEST(SPSCLockFreeQueueTest, CacheLineLayout) {
+  EXPECT_GE(alignof(SPSCLockFreeQueue<int>), 64u);
+  EXPECT_GE(sizeof(SPSCLockFreeQueue<int>), 3 * 64u);
+}
+
+// Cached indices stay coherent when the queue repeatedly fills and drains
+TEST(SPSCLockFreeQueueTest, CachedIndicesFillDrain) {
+  SPSCLockFreeQueue<int> q(3);
+  int v;
+  for (int round = 0; round < 5; ++round) {
+    EXPECT_TRUE(q.try_push(round));
+    EXPECT_TRUE(q.try_push(round + 1));
+    EXPECT_TRUE(q.try_push(round + 2));
+    EXPECT_FALSE(q.try_push(-1));
+    EXPECT_TRUE(q.try_pop(v));
+    EXPECT_EQ(v, round);
+    EXPECT_TRUE(q.try_push(round + 3));
+    EXPECT_FALSE(q.try_push(-1));
+    for (int i = 1; i <= 3; ++i) {
+      EXPECT_TRUE(q.try_pop(v));
+      EXPECT_EQ(v, round + i);
+    }
+    EXPECT_FALSE(q.try_pop(v));
+  }
+}
+
+// Power-of-two mode rounds capacity up and uses every slot
+TEST(SPSCLockFreeQueueTest, PowerOfTwoCapacity) {
+  SPSCPow2Queue<int> q(5);
+  EXPECT_EQ(q.capacity(), 8u);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(q.try_push(i));
+    EXPECT_EQ(q.size(), static_cast<size_t>(i + 1));
+  }
+  EXPECT_TRUE(q.full());
+  EXPECT_FALSE(q.try_push(8));
+  int v;
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(q.try_pop(v));
+    EXPECT_EQ(v, i);
+  }
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop(v));
+  EXPECT_EQ(SPSCPow2Queue<int>(4).capacity(), 4u);
+  EXPECT_EQ(SPSCLockFreeQueue<int>(5).capacity(), 5u);
+}
+
+// Power-of-two mode wraps its free-running counters over the buffer
+TEST(SPSCLockFreeQueueTest, PowerOfTwoWrapAround) {
+  SPSCPow2Queue<int> q(4);
+  std::vector<int> out;
+  int next = 0;
+  for (int round = 0; round < 10; ++round) {
+    std::vector<int> in{next, next + 1, next + 2};
+    next += 3;
+    ASSERT_EQ(q.try_push_n(in), 3u);
+    ASSERT_EQ(q.size(), 3u);
+    int v;
+    ASSERT_TRUE(q.try_pop(v));
+    out.push_back(v);
+    ASSERT_EQ(q.try_pop_n(std::back_inserter(out), 4), 2u);
+  }
+  for (int i = 0; i < 30; ++i) {
+    EXPECT_EQ(out[i], i);
+  }
+}
+
+// Power-of-two mode under concurrent producer and consumer
+TEST(SPSCLockFreeQueueTest, PowerOfTwoConcurrent) {
+  SPSCPow2Queue<int> q(16);
+  std::vector<int> results;
+  std::thread producer([&]() {
+    for (int i = 0; i < 1000; ++i) {
+      while (!q.try_push(i)) {
+      }
+    }
+  });
+  std::thread consumer([&]() {
+    int v;
+    for (int i = 0; i < 1000; ++i) {
+      while (!q.try_pop(v)) {
+      }
+      results.push_back(v);
+    }
+  });
+  producer.join();
+  consumer.join();
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(results[i], i);
+  }
+}
+
+// Blocking push/pop through a queue much smaller than the transfer
+TEST(SPSCLockFreeQueueTest, BlockingPushPop) {
+  SPSCLockFreeQueue<int> q(2);
+  std::vector<int> results;
+  std::thread producer([&]() {
+    for (int i = 0; i < 500; ++i) {
+      q.push(i);
+    }
+  });
+  std::thread consumer([&]() {
+    int v;
+    for (int i = 0; i < 500; ++i) {
+      q.pop(v);
+      results.push_back(v);
+      if (i % 50 == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    }
+  });
+  producer.join();
+  consumer.join();
+  ASSERT_EQ(results.size(), 500u);
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(results[i], i);
+  }
+}
+
+// A parked consumer is woken by a non-blocking push
+TEST(SPSCLockFreeQueueTest, BlockingPopWokenByTryPush) {
+  BasicSPSCLockFreeQueue<std::unique_ptr<int>, SPSCIndexing::kPowerOfTwo,
+                         SPSCNoStats, SPSCBlocking::kPark>
+      q(4);
+  std::unique_ptr<int> v;
+  std::thread consumer([&]() { q.pop(v); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_TRUE(q.try_push(std::make_unique<int>(7)));
+  consumer.join();
+  ASSERT_TRUE(v);
+  EXPECT_EQ(*v, 7);
+}
+
+// Timed operations give up at the deadline and succeed when unblocked
+TEST(SPSCLockFreeQueueTest, TimedPushPop) {
+  SPSCLockFreeQueue<int> q(1);
+  int v = 0;
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(q.pop_for(v, std::chrono::milliseconds(10)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(10));
+
+  EXPECT_TRUE(q.push_for(1, std::chrono::milliseconds(10)));
+  start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(q.push_until(2, start + std::chrono::milliseconds(10)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(10));
+
+  std::thread consumer([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    int out;
+    q.pop(out);
+  });
+  EXPECT_TRUE(q.push_for(2, std::chrono::seconds(5)));
+  consumer.join();
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  EXPECT_TRUE(q.pop_until(v, deadline));
+  EXPECT_EQ(v, 2);
+}
+
+// Move overloads leave the value untouched on timeout
+TEST(SPSCLockFreeQueueTest, TimedPushMoveKeepsValueOnTimeout) {
+  SPSCLockFreeQueue<std::unique_ptr<int>> q(1);
+  EXPECT_TRUE(q.try_push(std::make_unique<int>(1)));
+  auto value = std::make_unique<int>(2);
+  EXPECT_FALSE(q.push_for(std::move(value), std::chrono::milliseconds(1)));
+  ASSERT_TRUE(value);
+  EXPECT_EQ(*value, 2);
+}
+
+// Claim/commit and peek/release access slots in place
+TEST(SPSCLockFreeQueueTest, ClaimCommitPeekRelease) {
+  SPSCLockFreeQueue<int> q(2);
+  EXPECT_EQ(q.peek_read(), nullptr);
+  int* slot = q.claim_write();
+  ASSERT_NE(slot, nullptr);
+  *slot = 5;
+  EXPECT_TRUE(q.empty());
+  q.commit_write();
+  EXPECT_EQ(q.size(), 1u);
+  EXPECT_TRUE(q.try_push(6));
+  EXPECT_EQ(q.claim_write(), nullptr);
+
+  const int* front = q.peek_read();
+  ASSERT_NE(front, nullptr);
+  EXPECT_EQ(*front, 5);
+  EXPECT_EQ(q.peek_read(), front);
+  q.release_read();
+  int v;
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 6);
+  EXPECT_EQ(q.peek_read(), nullptr);
+}
+
+// A released element stays in its slot and is handed back on the next claim
+TEST(SPSCLockFreeQueueTest, ClaimReusesReleasedElement) {
+  SPSCPow2Queue<std::vector<float>> q(1);
+  std::vector<float>* slot = q.claim_write();
+  ASSERT_NE(slot, nullptr);
+  slot->assign(256, 1.0f);
+  const float* storage = slot->data();
+  q.commit_write();
+  ASSERT_NE(q.peek_read(), nullptr);
+  q.release_read();
+
+  slot = q.claim_write();
+  ASSERT_NE(slot, nullptr);
+  EXPECT_EQ(slot->data(), storage);
+  EXPECT_EQ(slot->size(), 256u);  // As the consumer left it
+  // Claiming again before committing returns the same element.
+  EXPECT_EQ(q.claim_write(), slot);
+  slot->assign(128, 2.0f);
+  EXPECT_EQ(slot->data(), storage);
+  q.commit_write();
+}
+
+// claim_write_fresh() replaces a released element with one built from its
+// arguments
+TEST(SPSCLockFreeQueueTest, ClaimFreshReplacesReleasedElement) {
+  SPSCPow2Queue<std::vector<float>> q(1);
+  std::vector<float>* slot = q.claim_write();
+  ASSERT_NE(slot, nullptr);
+  slot->assign(256, 1.0f);
+  q.commit_write();
+  ASSERT_NE(q.peek_read(), nullptr);
+  q.release_read();
+
+  slot = q.claim_write_fresh(3, 2.0f);
+  ASSERT_NE(slot, nullptr);
+  EXPECT_EQ(*slot, (std::vector<float>{2.0f, 2.0f, 2.0f}));
+  q.commit_write();
+  std::vector<float> arg{1.0f};
+  EXPECT_EQ(q.claim_write_fresh(std::move(arg)), nullptr);
+  EXPECT_EQ(arg.size(), 1u);  // Untouched while full
+  std::vector<float> out;
+  EXPECT_TRUE(q.try_pop(out));
+  EXPECT_EQ(out.size(), 3u);
+}
+
+// With the producer and consumer on separate threads, every frame after the
+// first lap is written into storage a released slot already owns
+TEST(SPSCLockFreeQueueTest, ClaimReusesStorageAcrossThreads) {
+  constexpr int kFrames = 2000;
+  SPSCPow2Queue<std::vector<float>> q(4);
+  std::vector<const float*> written;
+  written.reserve(kFrames);
+  std::thread producer([&]() {
+    for (int i = 0; i < kFrames; ++i) {
+      std::vector<float>* slot;
+      while ((slot = q.claim_write()) == nullptr) {
+        std::this_thread::yield();
+      }
+      slot->assign(256, static_cast<float>(i));
+      written.push_back(slot->data());
+      q.commit_write();
+    }
+  });
+  int errors = 0;
+  std::thread consumer([&]() {
+    for (int i = 0; i < kFrames; ++i) {
+      std::vector<float>* slot;
+      while ((slot = q.peek_read()) == nullptr) {
+        std::this_thread::yield();
+      }
+      errors += slot->size() != 256 || slot->back() != static_cast<float>(i);
+      q.release_read();
+    }
+  });
+  producer.join();
+  consumer.join();
+  EXPECT_EQ(errors, 0);
+  std::set<const float*> buffers(written.begin(), written.end());
+  EXPECT_EQ(buffers.size(), q.capacity());
+}
+
+// Zero-copy producer and consumer running concurrently
+TEST(SPSCLockFreeQueueTest, ClaimPeekConcurrent) {
+  SPSCLockFreeQueue<std::vector<int>> q(8);
+  std::vector<int> results;
+  std::thread producer([&]() {
+    for (int i = 0; i < 500; ++i) {
+      std::vector<int>* slot;
+      while ((slot = q.claim_write()) == nullptr) {
+      }
+      slot->assign(4, i);
+      q.commit_write();
+    }
+  });
+  std::thread consumer([&]() {
+    for (int i = 0; i < 500; ++i) {
+      std::vector<int>* slot;
+      while ((slot = q.peek_read()) == nullptr) {
+      }
+      ASSERT_EQ(slot->size(), 4u);
+      results.push_back(slot->back());
+      q.release_read();
+    }
+  });
+  producer.join();
+  consumer.join();
+  ASSERT_EQ(results.size(), 500u);
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(results[i], i);
+  }
+}
+
+namespace {
+// Element type without a default constructor that counts live instances.
+struct Tracked {
+  static inline int live = 0;
+  explicit Tracked(int v) : value(v) { ++live; }
+  Tracked(const Tracked& other) : value(other.value) { ++live; }
+  Tracked(Tracked&& other) noexcept : value(other.value) { ++live; }
+  Tracked& operator=(const Tracked&) = default;
+  Tracked& operator=(Tracked&&) = default;
+  ~Tracked() { --live; }
+  int value;
+};
+}  // namespace
+
+// Slots hold live elements between push and pop, and after release_read()
+// until the slot is written again
+TEST(SPSCLockFreeQueueTest, ElementLifetime) {
+  Tracked::live = 0;
+  {
+    SPSCLockFreeQueue<Tracked> q(8);
+    EXPECT_EQ(Tracked::live, 0);
+    EXPECT_TRUE(q.try_emplace(1));
+    EXPECT_TRUE(q.try_push(Tracked(2)));
+    q.emplace(3);
+    EXPECT_EQ(Tracked::live, 3);
+
+    Tracked out(0);
+    EXPECT_TRUE(q.try_pop(out));
+    EXPECT_EQ(out.value, 1);
+    EXPECT_EQ(Tracked::live, 3);  // out plus two queued
+
+    Tracked* front = q.peek_read();
+    ASSERT_NE(front, nullptr);
+    EXPECT_EQ(front->value, 2);
+    q.release_read();
+    EXPECT_EQ(Tracked::live, 3);  // The released element stays in its slot
+
+    Tracked* slot = q.claim_write_fresh(4);
+    ASSERT_NE(slot, nullptr);
+    q.commit_write();
+    EXPECT_EQ(Tracked::live, 4);
+  }
+  // The queue destroys elements left in it, released ones included.
+  EXPECT_EQ(Tracked::live, 0);
+
+  {
+    SPSCPow2Queue<Tracked> q(1);
+    EXPECT_TRUE(q.try_emplace(1));
+    ASSERT_NE(q.peek_read(), nullptr);
+    q.release_read();
+    EXPECT_EQ(Tracked::live, 1);
+    // Pushing over a released element destroys it first.
+    EXPECT_TRUE(q.try_emplace(2));
+    EXPECT_EQ(Tracked::live, 1);
+    Tracked out(0);
+    EXPECT_TRUE(q.try_pop(out));
+    EXPECT_EQ(out.value, 2);
+    EXPECT_EQ(Tracked::live, 1);
+    // So does claiming it fresh.
+    EXPECT_TRUE(q.try_emplace(3));
+    ASSERT_NE(q.peek_read(), nullptr);
+    q.release_read();
+    EXPECT_EQ(Tracked::live, 2);
+    ASSERT_NE(q.claim_write_fresh(4), nullptr);
+    EXPECT_EQ(Tracked::live, 2);
+    q.commit_write();
+  }
+  EXPECT_EQ(Tracked::live, 0);
+}
+
+// Emplace leaves its arguments untouched when the queue is full
+TEST(SPSCLockFreeQueueTest, TryEmplaceWhenFull) {
+  SPSCLockFreeQueue<std::vector<int>> q(1);
+  EXPECT_TRUE(q.try_emplace(3, 7));
+  std::vector<int> arg{1, 2};
+  EXPECT_FALSE(q.try_emplace(std::move(arg)));
+  EXPECT_EQ(arg.size(), 2u);
+  std::vector<int> out;
+  EXPECT_TRUE(q.try_pop(out));
+  EXPECT_EQ(out, (std::vector<int>{7, 7, 7}));
+}
+
+// Instrumentation counts failures and peak occupancy
+TEST(SPSCLockFreeQueueTest, StatsCounters) {
+  SPSCInstrumentedQueue<int> q(3);
+  int v;
+  EXPECT_FALSE(q.try_pop(v));
+  EXPECT_EQ(q.peek_read(), nullptr);
+  EXPECT_TRUE(q.try_push(1));
+  EXPECT_EQ(q.try_push_n(std::vector<int>{2, 3, 4}), 2u);
+  EXPECT_FALSE(q.try_push(5));
+  EXPECT_EQ(q.claim_write_fresh(6), nullptr);
+  EXPECT_EQ(q.try_push_n(std::vector<int>{7}), 0u);
+
+  auto stats = q.stats().snapshot();
+  EXPECT_EQ(stats.push_full, 3u);
+  EXPECT_EQ(stats.pop_empty, 2u);
+  EXPECT_EQ(stats.peak_occupancy, 3u);
+
+  std::vector<int> out(3);
+  EXPECT_EQ(q.try_pop_n(out), 3u);
+  EXPECT_TRUE(q.try_push(8));
+  EXPECT_EQ(q.stats().snapshot().peak_occupancy, 3u);
+}
+
+// Instrumentation accumulates the time a side could not make progress
+TEST(SPSCLockFreeQueueTest, StatsStallTime) {
+  SPSCInstrumentedQueue<int> q(1);
+  int v;
+  EXPECT_FALSE(q.try_pop(v));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_FALSE(q.try_pop(v));
+  EXPECT_TRUE(q.try_push(1));
+  EXPECT_FALSE(q.try_push(2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_TRUE(q.try_push(2));
+
+  auto stats = q.stats().snapshot();
+  EXPECT_GE(stats.consumer_stalled, std::chrono::milliseconds(5));
+  EXPECT_GE(stats.producer_stalled, std::chrono::milliseconds(5));
+  EXPECT_EQ(stats.pop_empty, 2u);
+  EXPECT_EQ(stats.push_full, 1u);
+}
+
+// Snapshots can be taken from a third thread while the queue is in use, and
+// the default policy adds no state
+TEST(SPSCLockFreeQueueTest, StatsConcurrentSnapshot) {
+  static_assert(sizeof(SPSCLockFreeQueue<int>) <
+                sizeof(SPSCInstrumentedQueue<int>));
+  SPSCInstrumentedQueue<int> q(8);
+  std::atomic<bool> done{false};
+  std::thread producer([&]() {
+    for (int i = 0; i < 2000; ++i) {
+      q.push(i);
+    }
+  });
+  std::thread consumer([&]() {
+    int v;
+    for (int i = 0; i < 2000; ++i) {
+      q.pop(v);
+    }
+    done = true;
+  });
+  size_t peak = 0;
+  while (!done) {
+    peak = std::max(peak, q.stats().snapshot().peak_occupancy);
+    std::this_thread::yield();
+  }
+  producer.join();
+  consumer.join();
+  EXPECT_LE(peak, 8u);
+  EXPECT_GE(q.stats().snapshot().peak_occupancy, 1u);
+}
+
+// wake_consumer() interrupts a parked consumer without any data
+TEST(SPSCLockFreeQueueTest, WakeInterruptsParkedConsumer) {
+  SPSCParkingQueue<int> q(4);
+  std::atomic<bool> cancelled = false;
+  std::thread consumer([&]() {
+    while (!cancelled.load()) {
+      q.wait_for_data([&] { return cancelled.load(); });
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  cancelled.store(true);
+  q.wake_consumer();
+  consumer.join();
+  EXPECT_TRUE(q.empty());
+}
+
+// wait_for_space() returns once the consumer pops
+TEST(SPSCLockFreeQueueTest, WaitForSpaceWokenByPop) {
+  SPSCParkingQueue<int> q(1);
+  EXPECT_TRUE(q.try_push(1));
+  std::thread producer([&]() {
+    while (q.full()) {
+      q.wait_for_space();
+    }
+    EXPECT_TRUE(q.try_push(2));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  int v;
+  EXPECT_TRUE(q.try_pop(v));
+  producer.join();
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 2);
+}
+
+template <typename Queue>
+concept Wakeable = requires(Queue& q) { q.wake_consumer(); };
+
+// Parking queues block with wake-ups; the default queue yields instead
+TEST(SPSCLockFreeQueueTest, ParkingQueueBlockingPushPop) {
+  static_assert(Wakeable<SPSCParkingQueue<int>>);
+  static_assert(!Wakeable<SPSCLockFreeQueue<int>>);
+  static_assert(!Wakeable<SPSCPow2Queue<int>>);
+  SPSCParkingQueue<int> q(2);
+  std::vector<int> results;
+  std::thread producer([&]() {
+    for (int i = 0; i < 500; ++i) {
+      q.push(i);
+    }
+  });
+  int v;
+  for (int i = 0; i < 500; ++i) {
+    q.pop(v);
+    results.push_back(v);
+  }
+  producer.join();
+  ASSERT_EQ(results.size(), 500u);
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(results[i], i);
+  }
+}
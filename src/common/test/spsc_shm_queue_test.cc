@@ -0,0 +1,155 @@
+#include "../src/spsc_shm_queue.hh"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include "../src/speech_filter.hh"
+
+namespace {
+// Builds a shared-memory name unique to this process and test.
+std::string shmName(const char* test) {
+  return "/speech_tools_" + std::to_string(getpid()) + "_" + test;
+}
+
+struct Sample {
+  uint32_t seq;
+  float value[4];
+};
+}  // namespace
+
+// Creator and attached handle see the same queue
+TEST(SPSCSharedMemoryQueueTest, CreateAttachFifo) {
+  std::string name = shmName("fifo");
+  SPSCSharedMemoryQueue<int> producer(name, 3);
+  EXPECT_EQ(producer.capacity(), 4u);
+  SPSCSharedMemoryQueue<int> consumer(name);
+  EXPECT_EQ(consumer.capacity(), 4u);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(producer.try_push(i));
+  }
+  EXPECT_TRUE(consumer.full());
+  EXPECT_FALSE(producer.try_push(4));
+  int v;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(consumer.try_pop(v));
+    EXPECT_EQ(v, i);
+  }
+  EXPECT_FALSE(consumer.try_pop(v));
+  EXPECT_TRUE(producer.empty());
+}
+
+// Attaching validates existence and element layout, creating rejects reuse
+TEST(SPSCSharedMemoryQueueTest, AttachValidation) {
+  std::string name = shmName("validate");
+  EXPECT_THROW(SPSCSharedMemoryQueue<int>{name}, std::runtime_error);
+  {
+    SPSCSharedMemoryQueue<int> created(name, 8);
+    EXPECT_THROW((SPSCSharedMemoryQueue<int>(name, 8)), std::runtime_error);
+    EXPECT_THROW(SPSCSharedMemoryQueue<Sample>{name}, std::runtime_error);
+    EXPECT_NO_THROW(SPSCSharedMemoryQueue<int>{name});
+  }
+  // The creator removes the name when it goes away.
+  EXPECT_THROW(SPSCSharedMemoryQueue<int>{name}, std::runtime_error);
+}
+
+// Attaching rejects a header whose capacity would index outside the segment
+TEST(SPSCSharedMemoryQueueTest, AttachRejectsBadCapacity) {
+  std::string name = shmName("bad_capacity");
+  SPSCSharedMemoryQueue<int> created(name, 8);
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  void* addr = mmap(nullptr, 64, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  ASSERT_NE(addr, MAP_FAILED);
+  // The capacity field follows version, magic, element size and alignment.
+  auto* capacity = reinterpret_cast<uint64_t*>(static_cast<char*>(addr) + 24);
+  ASSERT_EQ(*capacity, 8u);
+
+  // Zero, not a power of two, and a size that wraps around to fit.
+  for (uint64_t bad : {uint64_t{0}, uint64_t{6}, uint64_t{1} << 62}) {
+    *capacity = bad;
+    EXPECT_THROW(SPSCSharedMemoryQueue<int>{name}, std::runtime_error);
+  }
+  *capacity = 8;
+  EXPECT_NO_THROW(SPSCSharedMemoryQueue<int>{name});
+  munmap(addr, 64);
+}
+
+// A handle attached to a queue already in use starts at its current position
+TEST(SPSCSharedMemoryQueueTest, AttachToQueueInUse) {
+  std::string name = shmName("in_use");
+  SPSCSharedMemoryQueue<int> producer(name, 2);
+  int v;
+  {
+    SPSCSharedMemoryQueue<int> consumer(name);
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_TRUE(producer.try_push(i));
+      EXPECT_TRUE(consumer.try_pop(v));
+    }
+  }
+  SPSCSharedMemoryQueue<int> consumer(name);
+  EXPECT_FALSE(consumer.try_pop(v));
+  EXPECT_TRUE(producer.try_push(5));
+  EXPECT_TRUE(consumer.try_pop(v));
+  EXPECT_EQ(v, 5);
+}
+
+// Producer and consumer in separate processes
+TEST(SPSCSharedMemoryQueueTest, CrossProcess) {
+  std::string name = shmName("cross");
+  SPSCSharedMemoryQueue<Sample> consumer(name, 16);
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    SPSCSharedMemoryQueue<Sample> producer(name);
+    for (uint32_t i = 0; i < 1000; ++i) {
+      Sample s{i, {0.5f * i, 1, 2, 3}};
+      while (!producer.try_push(s)) {
+      }
+    }
+    _exit(0);
+  }
+  Sample s;
+  uint32_t errors = 0;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    while (!consumer.try_pop(s)) {
+    }
+    errors += s.seq != i || s.value[0] != 0.5f * i;
+  }
+  int status = 0;
+  waitpid(child, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  EXPECT_EQ(errors, 0u);
+}
+
+// The shared-memory queue plugs into SpeechFilter
+class NegateFilter
+    : public SpeechTools::SpeechFilter<float, float, SPSCSharedMemoryQueue> {
+ public:
+  NegateFilter(SPSCSharedMemoryQueue<float>& in,
+               SPSCSharedMemoryQueue<float>& out)
+      : SpeechTools::SpeechFilter<float, float, SPSCSharedMemoryQueue>(in,
+                                                                         out) {}
+
+ protected:
+  float process(const float& input_data) override { return -input_data; }
+};
+
+TEST(SPSCSharedMemoryQueueTest, PlugsIntoSpeechFilter) {
+  SPSCSharedMemoryQueue<float> in(shmName("filter_in"), 4);
+  SPSCSharedMemoryQueue<float> out(shmName("filter_out"), 4);
+  NegateFilter filter(in, out);
+  EXPECT_TRUE(in.try_push(1.5f));
+  float v = 0;
+  while (!out.try_pop(v)) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(v, -1.5f);
+}
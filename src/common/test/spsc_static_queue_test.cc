@@ -0,0 +1,146 @@
+#include "../src/spsc_static_queue.hh"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../src/speech_filter.hh"
+
+template <typename T>
+using StaticQueue8 = SPSCStaticQueue<T, 8>;
+
+// Basic FIFO test
+TEST(SPSCStaticQueueTest, FifoOrder) {
+  SPSCStaticQueue<int, 4> q;
+  EXPECT_TRUE(q.try_push(1));
+  EXPECT_TRUE(q.try_push(2));
+  EXPECT_TRUE(q.try_push(3));
+  int v;
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 1);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 2);
+  EXPECT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 3);
+  EXPECT_TRUE(q.empty());
+}
+
+// Full/empty detection, size reporting and wrap-around
+TEST(SPSCStaticQueueTest, FullEmptyAndSize) {
+  SPSCStaticQueue<int, 3> q;
+  static_assert(SPSCStaticQueue<int, 3>::capacity() == 3);
+  int v;
+  for (int round = 0; round < 4; ++round) {
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(q.size(), 0u);
+    EXPECT_TRUE(q.try_push(round));
+    EXPECT_TRUE(q.try_push(round + 1));
+    EXPECT_TRUE(q.try_push(round + 2));
+    EXPECT_EQ(q.size(), 3u);
+    EXPECT_TRUE(q.full());
+    EXPECT_FALSE(q.try_push(-1));
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_TRUE(q.try_pop(v));
+      EXPECT_EQ(v, round + i);
+    }
+    EXPECT_FALSE(q.try_pop(v));
+  }
+}
+
+// Move-only type support
+TEST(SPSCStaticQueueTest, MoveOnlyType) {
+  SPSCStaticQueue<std::unique_ptr<int>, 2> q;
+  EXPECT_TRUE(q.try_push(std::make_unique<int>(42)));
+  std::unique_ptr<int> v;
+  EXPECT_TRUE(q.try_pop(v));
+  ASSERT_TRUE(v);
+  EXPECT_EQ(*v, 42);
+}
+
+// Types without a default constructor are stored, and elements left in the
+// queue are destroyed with it
+TEST(SPSCStaticQueueTest, NonDefaultConstructibleType) {
+  struct Counted {
+    explicit Counted(int v, int& live) : value(v), live(&live) { ++live; }
+    Counted(const Counted& other) : value(other.value), live(other.live) {
+      ++*live;
+    }
+    Counted& operator=(const Counted&) = default;
+    ~Counted() { --*live; }
+
+    int value;
+    int* live;
+  };
+  static_assert(!std::is_default_constructible_v<Counted>);
+
+  int live = 0;
+  {
+    SPSCStaticQueue<Counted, 4> q;
+    EXPECT_EQ(live, 0);  // Empty slots hold no elements
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_TRUE(q.try_push(Counted(i, live)));
+    }
+    EXPECT_EQ(live, 3);
+    Counted v(-1, live);
+    EXPECT_TRUE(q.try_pop(v));
+    EXPECT_EQ(v.value, 0);
+    EXPECT_EQ(live, 3);  // Two queued, plus v
+  }
+  EXPECT_EQ(live, 0);
+}
+
+// Single-producer, single-consumer concurrency
+TEST(SPSCStaticQueueTest, SPSCConcurrent) {
+  SPSCStaticQueue<int, 16> q;
+  std::vector<int> results;
+  std::thread producer([&]() {
+    for (int i = 0; i < 1000; ++i) {
+      while (!q.try_push(i)) {
+      }
+    }
+  });
+  std::thread consumer([&]() {
+    int v;
+    for (int i = 0; i < 1000; ++i) {
+      while (!q.try_pop(v)) {
+      }
+      results.push_back(v);
+    }
+  });
+  producer.join();
+  consumer.join();
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(results[i], i);
+  }
+}
+
+// Doubling filter running over static queues
+class StaticDummyFilter
+    : public SpeechTools::SpeechFilter<int, int, StaticQueue8> {
+ public:
+  StaticDummyFilter(StaticQueue8<int>& in, StaticQueue8<int>& out)
+      : SpeechTools::SpeechFilter<int, int, StaticQueue8>(in, out) {}
+
+ protected:
+  int process(const int& input_data) override { return input_data * 2; }
+};
+
+TEST(SPSCStaticQueueTest, PlugsIntoSpeechFilter) {
+  static_assert(SpeechTools::QueueWithValueType<StaticQueue8<int>, int>);
+  StaticQueue8<int> in, out;
+  StaticDummyFilter filter(in, out);
+  in.try_push(3);
+  in.try_push(7);
+  int v1 = 0, v2 = 0;
+  while (!out.try_pop(v1)) {
+    std::this_thread::yield();
+  }
+  while (!out.try_pop(v2)) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(v1, 6);
+  EXPECT_EQ(v2, 14);
+}
@@ -0,0 +1,114 @@
+#include "../src/thread_options.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cerrno>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "../src/speech_filter.hh"
+#include "../src/spsc_queue.hh"
+
+using IntQueue = SPSCLockFreeQueue<int>;
+
+class IncrementFilter
+    : public SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue> {
+ public:
+  IncrementFilter(IntQueue& in, IntQueue& out,
+                  SpeechTools::ThreadOptions options)
+      : SpeechTools::SpeechFilter<int, int, SPSCLockFreeQueue>(
+            in, out, SpeechTools::WaitStrategy::kYield, 1,
+            std::move(options)) {}
+
+  // Records the name of the thread that processed the last frame.
+  std::string thread_name;
+
+ protected:
+  int process(const int& input_data) override {
+#ifdef __linux__
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    thread_name = name;
+#endif
+    return input_data + 1;
+  }
+};
+
+// Applies options to a thread that stays alive until they were applied
+SpeechTools::ThreadOptionsStatus applyToNewThread(
+    const SpeechTools::ThreadOptions& options) {
+  std::atomic<bool> done = false;
+  std::thread thread([&done] { done.wait(false); });
+  SpeechTools::ThreadOptionsStatus status =
+      SpeechTools::applyThreadOptions(thread, options);
+  done = true;
+  done.notify_one();
+  thread.join();
+  return status;
+}
+
+TEST(ThreadOptionsTest, DefaultOptionsChangeNothing) {
+  SpeechTools::ThreadOptionsStatus status = applyToNewThread({});
+  EXPECT_TRUE(status.ok());
+}
+
+TEST(ThreadOptionsTest, InvalidCoreIsReported) {
+  SpeechTools::ThreadOptions options;
+  options.cpus = {-1};
+  SpeechTools::ThreadOptionsStatus status = applyToNewThread(options);
+  EXPECT_FALSE(status.ok());
+  EXPECT_NE(status.affinity, 0);
+  EXPECT_EQ(status.scheduling, 0);
+}
+
+#ifdef __linux__
+// A real-time policy either applies or fails with a reported error, e.g.
+// EPERM without CAP_SYS_NICE
+TEST(ThreadOptionsTest, RealTimePolicyReportsOutcome) {
+  SpeechTools::ThreadOptions options;
+  options.policy = SpeechTools::SchedPolicy::kFifo;
+  options.priority = 10;
+  SpeechTools::ThreadOptionsStatus status = applyToNewThread(options);
+  EXPECT_TRUE(status.scheduling == 0 || status.scheduling == EPERM)
+      << "scheduling: " << status.scheduling;
+}
+
+// Returns a CPU the calling thread may run on, which need not be CPU 0 in a
+// container or under taskset
+int allowedCpu() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        return cpu;
+      }
+    }
+  }
+  return 0;
+}
+
+// The filter thread is named and pinned before it processes a frame
+TEST(ThreadOptionsTest, FilterThreadIsConfigured) {
+  IntQueue in(8), out(8);
+  SpeechTools::ThreadOptions options;
+  options.cpus = {allowedCpu()};
+  options.name = "denoise-filter-thread";
+  IncrementFilter filter(in, out, options);
+  EXPECT_EQ(filter.threadStatus().affinity, 0);
+  EXPECT_EQ(filter.threadStatus().name, 0);
+
+  in.push(1);
+  int v;
+  out.pop(v);
+  EXPECT_EQ(v, 2);
+  // Written before the result was pushed, so popping it makes this safe.
+  EXPECT_EQ(filter.thread_name, "denoise-filter-");  // Cut to 15 characters
+}
+#endif
@@ -7,8 +7,8 @@
 using namespace SpeechTools;
 
 TEST(NoiseFilterTest, ConstructorDestructor) {
-  SPSCLockFreeQueue<std::vector<std::vector<float>>> in_queue(4);
-  SPSCLockFreeQueue<std::vector<std::vector<float>>> out_queue(4);
+  SPSCParkingQueue<std::vector<std::vector<float>>> in_queue(4);
+  SPSCParkingQueue<std::vector<std::vector<float>>> out_queue(4);
   // Scope to test constructor and destructor
   {
     NoiseFilter filter(in_queue, out_queue);